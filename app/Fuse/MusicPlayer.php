@@ -4,6 +4,7 @@ namespace App\Fuse;
 
 use App\Fuse\BaseFuse;
 use Engine\Fuse\Component;
+use Engine\Http\ResponseCache;
 use Engine\Storage\Storage;
 use Native\Mobile\Facades\Media;
 use Native\Mobile\Facades\Secure;
@@ -239,6 +240,9 @@ class MusicPlayer extends BaseFuse
     public function onLibraryScanned($event = [])
     {
         // Scan is complete, data is on disk.
+        // The scan rewrites album art, so cached art responses are stale
+        ResponseCache::forget('albumart');
+
         // Try direct load first for speed
         if (!$this->loadLibraryDirectly()) {
             $this->loadPersistedLibrary();
@@ -13,6 +13,11 @@ const Fuse = {
    */
   components: {},
 
+  /**
+   * @var {Object} pageCache HTML and ETag of recently navigated pages, revalidated with If-None-Match
+   */
+  pageCache: {},
+
   /**
    * Parse an action string like: "save('a', 1)"
    *
@@ -333,20 +338,31 @@ const Fuse = {
       // Use prefetch cache if available, otherwise fetch
       let html = this.prefetchCache[url];
       if (!html) {
-        const response = await fetch(url, {
-          headers: {
-            "X-FUSE-NAVIGATE": "true",
-          },
-        });
+        // Revalidate a page we have seen: an unchanged page answers 304 without a body
+        const cached = this.pageCache[url];
+        const headers = { "X-FUSE-NAVIGATE": "true" };
+        if (cached) headers["If-None-Match"] = cached.etag;
+
+        const response = await fetch(url, { headers });
 
         if (response.redirected) {
           window.location.href = response.url;
           return;
         }
 
-        if (!response.ok) throw new Error("Navigation failed");
+        // The Android bridge delivers a 304 as 204 + X-Bridge-Not-Modified
+        const notModified =
+          response.status === 304 ||
+          response.headers.get("X-Bridge-Not-Modified") === "1";
+
+        if (notModified && cached) {
+          html = cached.html;
+        } else {
+          if (!response.ok) throw new Error("Navigation failed");
 
-        html = await response.text();
+          html = await response.text();
+          this.rememberPage(url, response.headers.get("ETag"), html);
+        }
       }
 
       // Parse HTML
@@ -390,6 +406,22 @@ const Fuse = {
     }
   },
 
+  /**
+   * Keep a navigated page's HTML under its ETag (the last 20 pages).
+   *
+   * @param {string} url
+   * @param {string|null} etag
+   * @param {string} html
+   */
+  rememberPage(url, etag, html) {
+    delete this.pageCache[url];
+    if (!etag) return;
+
+    this.pageCache[url] = { etag, html };
+    const urls = Object.keys(this.pageCache);
+    if (urls.length > 20) delete this.pageCache[urls[0]];
+  },
+
   /**
    * Handle browser back/forward buttons.
    */
@@ -76,7 +76,7 @@ $router->get('/fuse/login', function () {
 $router->get('/docs', function (Request $request) {
   $current = $request->input('section') ?? 'introduction';
   return Docs::renderPage(['title' => 'Fuse Docs', 'current' => $current]);
-});
+})->cache(300, ['session']);
 
 // Fuse Native Demo
 $router->get('/music', function () {
@@ -97,15 +97,18 @@ $router->get('/music/albumart/default', function () {
     $path = $localPath;
   }
 
-  $body = $path ? (file_get_contents($path) ?: '') : '';
-  if ($body === '') {
-    $body = '<svg xmlns="http://www.w3.org/2000/svg" width="300" height="300" viewBox="0 0 300 300"><rect width="300" height="300" fill="#111827"/><text x="150" y="160" text-anchor="middle" font-family="Arial" font-size="20" fill="#9ca3af">No Cover</text></svg>';
+  if ($path && filesize($path) > 0) {
+    return $res
+      ->header('Cache-Control', 'public, max-age=86400')
+      ->file($path, 'image/svg+xml; charset=utf-8');
   }
 
+  $body = '<svg xmlns="http://www.w3.org/2000/svg" width="300" height="300" viewBox="0 0 300 300"><rect width="300" height="300" fill="#111827"/><text x="150" y="160" text-anchor="middle" font-family="Arial" font-size="20" fill="#9ca3af">No Cover</text></svg>';
+
   return $res
     ->header('Cache-Control', 'public, max-age=86400')
     ->raw($body, 'image/svg+xml; charset=utf-8', 200);
-});
+})->cache(3600, [], ['albumart']);
 
 $router->get('/music/albumart/{id}', function ($id) {
   $res = new Response();
@@ -130,15 +133,11 @@ $router->get('/music/albumart/{id}', function ($id) {
     return $res->setStatus(302)->header('Location', '/music/albumart/default')->raw('', 'text/plain; charset=utf-8', 302);
   }
 
-  $body = file_get_contents($path);
-  if ($body === false) {
-    return $res->setStatus(302)->header('Location', '/music/albumart/default')->raw('', 'text/plain; charset=utf-8', 302);
-  }
-
+  // Sent from disk by the bridge (Range-aware), never read into PHP
   return $res
     ->header('Cache-Control', 'public, max-age=86400')
-    ->raw($body, 'image/jpeg', 200);
-});
+    ->file($path, 'image/jpeg');
+})->cache(3600, [], ['albumart']);
 
 // Native event ingestion endpoint for WebView bridge
 $router->post('/_native/api/events', function (Request $request) {
@@ -90,12 +90,7 @@ class Bootstrap
             session_save_path($sessionPath);
         }
 
-        // Avoid sessions for static asset requests to prevent extra session files
-        $uri = $_SERVER['REQUEST_URI'] ?? '';
-        $isAsset = (bool) preg_match('#\.(css|js|png|jpg|jpeg|webp|gif|svg|ico|woff|woff2|ttf|eot|otf|json|pdf|txt|xml)$#i', $uri);
-        if (!$isAsset && session_status() !== PHP_SESSION_ACTIVE) {
-            session_start();
-        }
+        self::startSession();
 
         // Initialize Config
         Config::load($config);
@@ -107,6 +102,24 @@ class Bootstrap
         ];
     }
 
+    /**
+     * Start the session for the current request.
+     *
+     * Static asset requests are skipped to prevent extra session files.
+     * Called once from init() and again per request by the mobile worker,
+     * which keeps the framework booted between requests.
+     *
+     * @return void
+     */
+    public static function startSession(): void
+    {
+        $uri = $_SERVER['REQUEST_URI'] ?? '';
+        $isAsset = (bool) preg_match('#\.(css|js|png|jpg|jpeg|webp|gif|svg|ico|woff|woff2|ttf|eot|otf|json|pdf|txt|xml)$#i', $uri);
+        if (!$isAsset && session_status() !== PHP_SESSION_ACTIVE) {
+            session_start();
+        }
+    }
+
     /**
      * Load a configuration file with default fallbacks.
      *
@@ -16,6 +16,7 @@ class Kernel
 {
     protected Router $router;
     protected array $middleware = [];
+    protected bool $routesLoaded = false;
 
     /**
      * Create a new Kernel instance.
@@ -41,14 +42,8 @@ class Kernel
      */
     public function handle(Request $request)
     {
-        // Load routes
-        $router = $this->router;
-
-        // Load Web Routes
-        require_once dirname(__DIR__, 3) . '/routes/web.php';
-
-        // Load API Routes with prefix
-        $this->loadApiRoutes($router);
+        // Load routes (once per Kernel, so a long-lived worker keeps them compiled)
+        $this->loadRoutes();
 
         // Match route
         $route = $this->router->match($request->method, $request->uri);
@@ -58,6 +53,8 @@ class Kernel
             return;
         }
 
+        $this->applyTimeout($route);
+
         // Combine global and route-specific middleware
         $middlewareStack = array_merge($this->middleware, $route['middleware'] ?? []);
 
@@ -67,21 +64,132 @@ class Kernel
         });
 
         // Send final response
+        if (is_array($response) && isset($response[0]) && is_int($response[0])) {
+            // A standard [status, body] array
+            $response = $this->makeResponse($response[0], $response[1]);
+        } elseif (is_array($response) || is_string($response)) {
+            // JSON data or HTML
+            $response = $this->makeResponse(200, $response);
+        }
+
         if ($response instanceof Response) {
+            $this->applyCache($route, $request, $response);
             $response->send();
-        } elseif (is_array($response)) {
-            // Check if it's a standard [status, body] array
-            if (isset($response[0]) && is_int($response[0])) {
-                $this->sendResponse($response[0], $response[1]);
-            } else {
-                // Otherwise treat as JSON data
-                $this->sendResponse(200, $response);
+        }
+    }
+
+    /**
+     * Mark a response for the mobile bridge's response cache (Router ->cache()).
+     *
+     * The X-Bridge-Cache header is consumed by the bridge, which stores the
+     * finished response and serves later hits without running PHP.
+     *
+     * @param array $route
+     * @param Request $request
+     * @param Response $response
+     * @return void
+     */
+    protected function applyCache(array $route, Request $request, Response $response): void
+    {
+        if (!isset($route['cache']) || $request->method !== 'GET' || !extension_loaded('nativephp')) {
+            return;
+        }
+
+        $cache = $route['cache'];
+        $vary = array_map(function (string $key) {
+            if ($key === 'session') {
+                return 'cookie:' . session_name();
+            }
+            return str_starts_with($key, 'cookie:') ? $key : 'header:' . $key;
+        }, $cache['vary']);
+
+        $response->header('X-Bridge-Cache', sprintf(
+            'ttl=%d; vary=%s; tags=%s',
+            $cache['ttl'],
+            implode(',', $vary),
+            implode(',', $cache['tags'])
+        ));
+    }
+
+    /**
+     * Load routes and the classes every request needs, without dispatching.
+     *
+     * Used by the mobile warm-up request, so the first real navigation reaches
+     * a worker whose routes are compiled and whose hot classes (middleware,
+     * Request/Response, Fuse, route handlers) are already declared.
+     *
+     * @return void
+     */
+    public function warm(): void
+    {
+        $this->loadRoutes();
+
+        $classes = array_merge($this->middleware, [
+            Request::class,
+            Response::class,
+            \Engine\Fuse\Manager::class,
+            \Engine\Fuse\Component::class,
+        ]);
+
+        foreach ($this->router->getRoutes() as $route) {
+            if (is_array($route['handler']) && is_string($route['handler'][0] ?? null)) {
+                $classes[] = $route['handler'][0];
             }
-        } elseif (is_string($response)) {
-            $this->sendResponse(200, $response);
+        }
+
+        foreach (array_unique($classes) as $class) {
+            class_exists($class);
         }
     }
 
+    /**
+     * Apply a route's ->timeout() to the running request.
+     *
+     * Under the mobile bridge the limit moves the native watchdog's deadline
+     * (signal-based max_execution_time is not reliable there); otherwise it
+     * falls back to set_time_limit().
+     *
+     * @param array $route
+     * @return void
+     */
+    protected function applyTimeout(array $route): void
+    {
+        if (!isset($route['timeout'])) {
+            return;
+        }
+
+        if (function_exists('nativephp_deadline')) {
+            nativephp_deadline($route['timeout'] * 1000);
+        } else {
+            set_time_limit($route['timeout']);
+        }
+    }
+
+    /**
+     * Load web and API route files into the router.
+     *
+     * Runs only once per Kernel instance. The mobile worker reuses the same
+     * Kernel for every request, so route files must not be re-required.
+     *
+     * @return void
+     */
+    protected function loadRoutes(): void
+    {
+        if ($this->routesLoaded) {
+            return;
+        }
+
+        $router = $this->router;
+
+        // Load Web Routes
+        require_once dirname(__DIR__, 3) . '/routes/web.php';
+
+        // Load API Routes with prefix
+        $this->loadApiRoutes($router);
+
+        $this->routesLoaded = true;
+    }
+
     /**
      * Load API routes with /api prefix.
      *
@@ -208,23 +316,47 @@ class Kernel
     /**
      * Send the HTTP response.
      *
+     * Plain strings and arrays are wrapped in a Response, so they get the
+     * same ETag / 304 handling as controller-built responses.
+     *
      * @param int $status
      * @param mixed $body
      */
     protected function sendResponse(int $status, $body)
+    {
+        $this->makeResponse($status, $body)->send();
+    }
+
+    /**
+     * Wrap a handler's plain string or array result in a Response.
+     *
+     * @param int $status
+     * @param mixed $body
+     * @return Response
+     */
+    protected function makeResponse(int $status, $body): Response
     {
         if ($body instanceof Response) {
-            $body->send();
-            return;
+            return $body;
         }
 
-        http_response_code($status);
+        return is_array($body) || is_object($body)
+            ? (new Response())->raw(json_encode($body), 'application/json', $status)
+            : (new Response())->raw((string) $body, $this->sentContentType(), $status);
+    }
 
-        if (is_array($body) || is_object($body)) {
-            header('Content-Type: application/json');
-            echo json_encode($body);
-        } else {
-            echo $body;
+    /**
+     * Content-Type a handler already set with header(), or HTML.
+     *
+     * @return string
+     */
+    protected function sentContentType(): string
+    {
+        foreach (array_reverse(headers_list()) as $line) {
+            if (stripos($line, 'Content-Type:') === 0) {
+                return trim(substr($line, 13));
+            }
         }
+        return 'text/html; charset=utf-8';
     }
 }
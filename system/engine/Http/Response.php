@@ -24,6 +24,21 @@ class Response
      */
     protected string $body = '';
 
+    /**
+     * @var string|null File sent by send() in place of $body
+     */
+    protected ?string $file = null;
+
+    /**
+     * @var int First byte of $file to send
+     */
+    protected int $fileOffset = 0;
+
+    /**
+     * @var int Number of bytes of $file to send
+     */
+    protected int $fileLength = 0;
+
     /**
      * Set the HTTP status code.
      *
@@ -99,19 +114,315 @@ class Response
         return $this;
     }
 
+    /**
+     * Stream a file as the body, honouring a "Range: bytes=" request.
+     *
+     * The file is copied to the output from the requested offset when the
+     * response is sent, so large media never sits in memory. A satisfiable
+     * range answers 206 with Content-Range, an unsatisfiable one 416.
+     *
+     * @param string $path File to send
+     * @param string $contentType Content-Type header value
+     * @param string|null $range Range header value; defaults to the current request's
+     * @return self
+     */
+    public function stream(string $path, string $contentType = 'application/octet-stream', ?string $range = null): self
+    {
+        $size = is_file($path) ? filesize($path) : false;
+        if ($size === false) {
+            return $this->raw('Not Found', 'text/plain; charset=utf-8', 404);
+        }
+
+        $this->body = '';
+        $this->header('Content-Type', $contentType);
+        $this->header('Accept-Ranges', 'bytes');
+
+        // Validators from the file itself, so a revalidation never opens it
+        $mtime = filemtime($path) ?: time();
+        $this->headers['ETag'] ??= sprintf('"%x-%x"', $mtime, $size);
+        $this->headers['Last-Modified'] ??= gmdate('D, d M Y H:i:s', $mtime) . ' GMT';
+
+        $range ??= $_SERVER['HTTP_RANGE'] ?? null;
+        $bounds = $range !== null ? static::parseRange($range, $size) : null;
+
+        if ($bounds === false) {
+            $this->file = null;
+            $this->header('Content-Range', 'bytes */' . $size);
+            return $this->setStatus(416);
+        }
+
+        [$start, $end] = $bounds ?? [0, $size - 1];
+        if ($bounds !== null) {
+            $this->setStatus(206);
+            $this->header('Content-Range', "bytes {$start}-{$end}/{$size}");
+        } else {
+            $this->setStatus(200);
+        }
+
+        $this->file = $path;
+        $this->fileOffset = $start;
+        $this->fileLength = max(0, $end - $start + 1);
+        $this->header('Content-Length', (string) $this->fileLength);
+        return $this;
+    }
+
+    /**
+     * Send a file without reading it in PHP.
+     *
+     * Under the mobile bridge only headers are sent: an X-Sendfile header
+     * names the file and the bridge copies it from disk to the WebView
+     * itself. Elsewhere this behaves like stream(). Range requests are
+     * honoured either way.
+     *
+     * @param string $path File to send
+     * @param string|null $contentType Content-Type header value; guessed from the extension when null
+     * @param string|null $range Range header value; defaults to the current request's
+     * @return self
+     */
+    public function file(string $path, ?string $contentType = null, ?string $range = null): self
+    {
+        $this->stream($path, $contentType ?? static::mimeType($path), $range);
+
+        if ($this->file !== null && extension_loaded('nativephp')) {
+            $this->header('X-Sendfile', realpath($this->file) ?: $this->file);
+            $this->file = null;
+        }
+        return $this;
+    }
+
+    /**
+     * Send a file as an attachment.
+     *
+     * @param string $path File to send
+     * @param string|null $name File name offered to the user; defaults to the file's own
+     * @param string|null $contentType Content-Type header value; guessed from the extension when null
+     * @return self
+     */
+    public function download(string $path, ?string $name = null, ?string $contentType = null): self
+    {
+        $this->file($path, $contentType);
+        if ($this->status >= 400) {
+            return $this;
+        }
+
+        $name ??= basename($path);
+        $fallback = str_replace(['"', '\\'], '_', preg_replace('/[^\x20-\x7e]/', '_', $name));
+        return $this->header(
+            'Content-Disposition',
+            'attachment; filename="' . $fallback . '"; filename*=UTF-8\'\'' . rawurlencode($name)
+        );
+    }
+
+    /**
+     * Guess a Content-Type from a file's extension.
+     *
+     * @param string $path
+     * @return string
+     */
+    protected static function mimeType(string $path): string
+    {
+        return match (strtolower(pathinfo($path, PATHINFO_EXTENSION))) {
+            'jpg', 'jpeg' => 'image/jpeg',
+            'png' => 'image/png',
+            'gif' => 'image/gif',
+            'webp' => 'image/webp',
+            'svg' => 'image/svg+xml',
+            'mp3' => 'audio/mpeg',
+            'm4a' => 'audio/mp4',
+            'ogg' => 'audio/ogg',
+            'wav' => 'audio/wav',
+            'mp4' => 'video/mp4',
+            'webm' => 'video/webm',
+            'pdf' => 'application/pdf',
+            'json' => 'application/json',
+            'txt' => 'text/plain; charset=utf-8',
+            'zip' => 'application/zip',
+            default => 'application/octet-stream',
+        };
+    }
+
+    /**
+     * Set the ETag validator.
+     *
+     * @param string $tag Opaque version of the content (quoted if it is not already)
+     * @param bool $weak Mark the tag as weak (W/)
+     * @return self
+     */
+    public function etag(string $tag, bool $weak = false): self
+    {
+        if (!str_starts_with($tag, '"') && !str_starts_with($tag, 'W/"')) {
+            $tag = '"' . $tag . '"';
+        }
+        if ($weak && !str_starts_with($tag, 'W/')) {
+            $tag = 'W/' . $tag;
+        }
+        return $this->header('ETag', $tag);
+    }
+
+    /**
+     * Set the Last-Modified validator.
+     *
+     * @param int|\DateTimeInterface $time Unix timestamp or date
+     * @return self
+     */
+    public function lastModified(int|\DateTimeInterface $time): self
+    {
+        $timestamp = $time instanceof \DateTimeInterface ? $time->getTimestamp() : $time;
+        return $this->header('Last-Modified', gmdate('D, d M Y H:i:s', $timestamp) . ' GMT');
+    }
+
+    /**
+     * Set the Cache-Control header.
+     *
+     * @param string $value e.g. "no-cache" (always revalidate) or "public, max-age=60"
+     * @return self
+     */
+    public function cacheControl(string $value): self
+    {
+        return $this->header('Cache-Control', $value);
+    }
+
+    /**
+     * Check the request's If-None-Match / If-Modified-Since against this
+     * response's ETag and Last-Modified.
+     *
+     * On a match the response becomes an empty 304 and true is returned. A
+     * route that can name its version cheaply (a row's updated_at, a file's
+     * mtime) calls this before rendering and returns early:
+     *
+     *     $res->etag($version);
+     *     if ($res->isNotModified()) return $res;
+     *
+     * @param array|null $server Request server vars; defaults to $_SERVER
+     * @return bool
+     */
+    public function isNotModified(?array $server = null): bool
+    {
+        $server ??= $_SERVER;
+        $method = $server['REQUEST_METHOD'] ?? 'GET';
+        if (($method !== 'GET' && $method !== 'HEAD') || ($this->status !== 200 && $this->status !== 206)) {
+            return false;
+        }
+
+        $etag = $this->headers['ETag'] ?? null;
+        $ifNoneMatch = $server['HTTP_IF_NONE_MATCH'] ?? null;
+        $lastModified = $this->headers['Last-Modified'] ?? null;
+        $ifModifiedSince = $server['HTTP_IF_MODIFIED_SINCE'] ?? null;
+
+        if ($ifNoneMatch !== null) {
+            // Weak comparison (RFC 9110 13.1.2); If-Modified-Since is ignored
+            $match = false;
+            if ($etag !== null) {
+                $own = preg_replace('#^W/#', '', $etag);
+                foreach (explode(',', $ifNoneMatch) as $candidate) {
+                    $candidate = trim($candidate);
+                    if ($candidate === '*' || preg_replace('#^W/#', '', $candidate) === $own) {
+                        $match = true;
+                        break;
+                    }
+                }
+            }
+        } elseif ($ifModifiedSince !== null && $lastModified !== null) {
+            $since = strtotime($ifModifiedSince);
+            $modified = strtotime($lastModified);
+            $match = $since !== false && $modified !== false && $modified <= $since;
+        } else {
+            $match = false;
+        }
+
+        if (!$match) {
+            return false;
+        }
+
+        $this->status = 304;
+        $this->body = '';
+        $this->file = null;
+        unset(
+            $this->headers['Content-Length'],
+            $this->headers['Content-Range'],
+            $this->headers['X-Sendfile']
+        );
+        return true;
+    }
+
+    /**
+     * Resolve a "bytes=" Range header against a file of $size bytes.
+     *
+     * Only a single range is honoured. Several ranges, other units or a
+     * malformed header return null, and the whole file is sent (RFC 9110
+     * allows ignoring Range).
+     *
+     * @param string $header Range header value
+     * @param int $size File size in bytes
+     * @return array{0: int, 1: int}|false|null Inclusive [start, end], false when unsatisfiable
+     */
+    public static function parseRange(string $header, int $size): array|false|null
+    {
+        if (!preg_match('/^\s*bytes\s*=\s*(\d*)\s*-\s*(\d*)\s*$/i', $header, $m) || ($m[1] === '' && $m[2] === '')) {
+            return null;
+        }
+
+        if ($m[1] === '') {
+            // Suffix range: the last N bytes
+            $length = (int) $m[2];
+            return ($length > 0 && $size > 0) ? [max(0, $size - $length), $size - 1] : false;
+        }
+
+        $start = (int) $m[1];
+        if ($m[2] !== '' && (int) $m[2] < $start) {
+            return null;
+        }
+        if ($start >= $size) {
+            return false;
+        }
+
+        $end = $m[2] === '' ? $size - 1 : min((int) $m[2], $size - 1);
+        return [$start, $end];
+    }
+
     /**
      * Send the response to the client.
      *
-     * Sends headers and outputs the body.
+     * Sends headers and outputs the body. A 200 GET without its own ETag gets
+     * one hashed from the finished body, and a request that already holds
+     * that version is answered with an empty 304.
      *
      * @return void
      */
     public function send(): void
     {
+        if ($this->status === 200 && $this->file === null && $this->body !== '' && !isset($this->headers['ETag'])) {
+            $this->headers['ETag'] = '"' . hash('xxh3', $this->body) . '"';
+        }
+        $this->isNotModified();
+
         http_response_code($this->status);
         foreach ($this->headers as $k => $v) {
             header($k . ': ' . $v);
         }
+
+        if ($this->file !== null) {
+            $this->sendFile();
+            return;
+        }
         echo $this->body;
     }
+
+    /**
+     * Copy the streamed file's byte range to the output in chunks.
+     *
+     * @return void
+     */
+    protected function sendFile(): void
+    {
+        $in = fopen($this->file, 'rb');
+        if ($in === false) {
+            return;
+        }
+
+        $out = fopen('php://output', 'wb');
+        stream_copy_to_stream($in, $out, $this->fileLength, $this->fileOffset);
+        fclose($out);
+        fclose($in);
+    }
 }
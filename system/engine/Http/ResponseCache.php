@@ -0,0 +1,39 @@
+<?php
+namespace Engine\Http;
+
+/**
+ * Class ResponseCache
+ *
+ * Invalidates responses the mobile bridge cached for routes marked with
+ * Router ->cache(). Outside the bridge there is no such cache and these
+ * calls do nothing.
+ */
+class ResponseCache
+{
+    /**
+     * Drop every cached response carrying one of the given tags.
+     *
+     * @param string|string[] $tags
+     * @return int Number of responses removed
+     */
+    public static function forget(string|array $tags): int
+    {
+        if (!function_exists('nativephp_cache_forget')) {
+            return 0;
+        }
+        return nativephp_cache_forget((array) $tags);
+    }
+
+    /**
+     * Drop every cached response.
+     *
+     * @return int Number of responses removed
+     */
+    public static function flush(): int
+    {
+        if (!function_exists('nativephp_cache_forget')) {
+            return 0;
+        }
+        return nativephp_cache_forget(null);
+    }
+}
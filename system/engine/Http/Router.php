@@ -53,6 +53,12 @@ use Engine\Core\Config;
  *
  *   7. Fallback (404)
  *   $router->fallback([ErrorController::class, 'notFound']);
+ *
+ *   8. Time limit (seconds) for a slow action
+ *   $router->post('/library/scan', [LibraryController::class, 'scan'])->timeout(120);
+ *
+ *   9. Keep the finished response in the mobile bridge's cache (seconds, vary, tags)
+ *   $router->get('/docs', [DocsController::class, 'show'])->cache(300, ['session'], ['docs']);
  */
 
 
@@ -123,6 +129,53 @@ class Router
         return $this;
     }
 
+    /**
+     * Give the last defined route its own time limit, in seconds (0 = none).
+     *
+     * Applied by the Kernel once the route matches: on mobile it moves the
+     * bridge watchdog's deadline, elsewhere it calls set_time_limit().
+     *
+     * @param int $seconds
+     * @return static
+     */
+    public function timeout(int $seconds): static
+    {
+        if ($this->lastRouteIndex === null) {
+            throw new \RuntimeException('timeout() must be called after defining a route.');
+        }
+
+        $this->routes[$this->lastRouteIndex]['timeout'] = max(0, $seconds);
+        return $this;
+    }
+
+    /**
+     * Let the mobile bridge cache the last defined route's finished response.
+     *
+     * A cached GET is answered natively, without entering PHP, until $ttl
+     * seconds pass or one of its tags is forgotten (ResponseCache::forget()).
+     * Only 200 responses without Set-Cookie are kept. The cache key is the
+     * URI including the query string, plus each $vary value: 'session' (the
+     * session cookie), 'cookie:<name>' or a request header name.
+     *
+     * @param int $ttl Seconds a response stays fresh
+     * @param string[] $vary Request values the response depends on
+     * @param string[] $tags Names to invalidate the response by
+     * @return static
+     */
+    public function cache(int $ttl, array $vary = [], array $tags = []): static
+    {
+        if ($this->lastRouteIndex === null) {
+            throw new \RuntimeException('cache() must be called after defining a route.');
+        }
+
+        $this->routes[$this->lastRouteIndex]['cache'] = [
+            'ttl' => max(0, $ttl),
+            'vary' => array_values($vary),
+            'tags' => array_values($tags),
+        ];
+        return $this;
+    }
+
     /* -------------------------------------------------------------
      | HTTP VERBS
      |-------------------------------------------------------------*/
@@ -246,6 +299,16 @@ class Router
      | Helpers
      |-------------------------------------------------------------*/
 
+    /**
+     * Every registered route, in registration order.
+     *
+     * @return array
+     */
+    public function getRoutes(): array
+    {
+        return $this->routes;
+    }
+
     public function fallback($handler): static
     {
         $this->fallbackHandler = $handler;
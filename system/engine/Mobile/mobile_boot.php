@@ -23,6 +23,7 @@ require_once $rootDir . '/system/engine/Core/Bootstrap.php';
 // Initialize the framework
 \Engine\Core\Bootstrap::init();
 
+use Engine\Core\Bootstrap;
 use Engine\Core\Kernel;
 use Engine\Http\Router;
 use Engine\Http\Request;
@@ -33,14 +34,54 @@ $router = new Router();
 $GLOBALS['__router'] = $router;
 $kernel = new Kernel($router);
 
-// Create the request object
+// Handle a single request.
 // The $_SERVER variables are already populated by the native C bridge
-$request = new Request();
-$GLOBALS['__randomColor'] = getRandomColor();
-Native::call('App.SetStatusBar', [
-  'color' => $GLOBALS['__randomColor'],
-  'style' => 'auto',
-  'overlay' => true
-]);
-// Handle the request
-$kernel->handle($request);
+$handle = function () use ($kernel) {
+  $GLOBALS['__randomColor'] = getRandomColor();
+  Native::call('App.SetStatusBar', [
+    'color' => $GLOBALS['__randomColor'],
+    'style' => 'auto',
+    'overlay' => true
+  ]);
+  $kernel->handle(new Request());
+};
+
+// Warm-up request (PHPBridge.warmUp): boot and load the hot classes, but do
+// not dispatch a route. In worker mode the worker below stays resident.
+$warmUp = ($_SERVER['HTTP_X_BRIDGE_WARMUP'] ?? '') === '1';
+if ($warmUp) {
+  $kernel->warm();
+  if (session_status() === PHP_SESSION_ACTIVE) {
+    session_write_close();
+  }
+}
+
+$workerMode = filter_var(getenv('MVC_WORKER_MODE') ?: false, FILTER_VALIDATE_BOOLEAN);
+if (!$workerMode) {
+  if (!$warmUp) {
+    $handle();
+  }
+  return;
+}
+
+// Worker mode: the native bridge keeps this PHP request alive and calls
+// $GLOBALS['__mobile_worker'] for every later request, so Bootstrap, config,
+// routes and the loaded classes are reused instead of rebuilt.
+$worker = function () use ($handle) {
+  Native::reset();
+  Bootstrap::startSession();
+  try {
+    $handle();
+  } finally {
+    if (session_status() === PHP_SESSION_ACTIVE) {
+      session_write_close();
+    }
+  }
+};
+
+$GLOBALS['__mobile_worker'] = $worker;
+
+// The session for this first request was already started by Bootstrap::init()
+if (!$warmUp) {
+  $worker();
+}
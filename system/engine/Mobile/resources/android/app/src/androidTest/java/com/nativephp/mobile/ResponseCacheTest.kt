@@ -0,0 +1,104 @@
+package com.fuse.php
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import com.fuse.php.bridge.PHPBridge
+import com.fuse.php.bridge.PHPResponse
+import com.fuse.php.bridge.RequestRecord
+import com.fuse.php.network.PHPRequest
+import java.io.File
+import org.junit.Assert.*
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+
+/**
+ * Native response cache (bridge_cache.c) with file responses: a route that
+ * sends X-Bridge-Cache and X-Sendfile must be answered from the cache with
+ * the file's bytes, without running PHP again.
+ */
+@RunWith(AndroidJUnit4::class)
+class ResponseCacheTest {
+    private val context = InstrumentationRegistry.getInstrumentation().targetContext
+    private val bridge = PHPBridge(context)
+    private val dir = File(context.cacheDir, "response-cache-test")
+    private val file = File(dir, "art.bin")
+    private val script = File(dir, "cached_file.php")
+
+    // Each test gets its own URI so entries cached by another test never answer it
+    private val uri = "/cache-test/art?run=${System.nanoTime()}"
+
+    @Before
+    fun setUp() {
+        dir.mkdirs()
+        file.writeBytes(ByteArray(4096) { (it % 251).toByte() })
+        script.writeText(
+            """
+            <?php
+            header('X-Bridge-Cache: ttl=60');
+            header('Content-Type: application/octet-stream');
+            header('ETag: "art-v1"');
+            header('Content-Length: ' . filesize('${file.absolutePath}'));
+            header('X-Sendfile: ${file.absolutePath}');
+            """.trimIndent()
+        )
+    }
+
+    private fun get(headers: Map<String, String> = emptyMap()): PHPResponse {
+        val record = RequestRecord.encode(
+            PHPRequest(url = uri, headers = headers),
+            script.absolutePath,
+            headers.keys.toTypedArray(),
+            headers.values.toTypedArray()
+        )
+        return bridge.nativeHandleRequestOnce(record, record.position())
+    }
+
+    private fun body(response: PHPResponse): ByteArray = response.bodyStream().use { it.readBytes() }
+
+    @Test
+    fun cachedFileHitSendsTheFile() {
+        val miss = get()
+        assertEquals(200, miss.status)
+        assertNull(miss.header("X-Cache"))
+        assertArrayEquals(file.readBytes(), body(miss))
+
+        val hit = get()
+        assertEquals(200, hit.status)
+        assertEquals("HIT", hit.header("X-Cache"))
+        assertEquals(file.length().toString(), hit.header("Content-Length"))
+        assertArrayEquals(file.readBytes(), body(hit))
+    }
+
+    @Test
+    fun rangeRequestsBypassTheCache() {
+        get()
+        val ranged = get(mapOf("Range" to "bytes=0-9"))
+        assertNull(ranged.header("X-Cache"))
+    }
+
+    @Test
+    fun ifNoneMatchIsComparedWeakly() {
+        get()
+        val notModified = get(mapOf("If-None-Match" to "\"other\", W/\"art-v1\""))
+        assertEquals(304, notModified.status)
+        assertEquals("HIT", notModified.header("X-Cache"))
+        assertNull(notModified.header("Content-Length"))
+        assertEquals(0, body(notModified).size)
+
+        val changed = get(mapOf("If-None-Match" to "\"art-v0\""))
+        assertEquals(200, changed.status)
+        assertArrayEquals(file.readBytes(), body(changed))
+    }
+
+    @Test
+    fun changedFileIsNotServedFromTheCache() {
+        get()
+        file.writeBytes(ByteArray(1024) { 7 })
+
+        val response = get()
+        assertNull(response.header("X-Cache"))
+        assertEquals("1024", response.header("Content-Length"))
+        assertArrayEquals(file.readBytes(), body(response))
+    }
+}
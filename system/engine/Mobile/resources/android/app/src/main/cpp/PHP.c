@@ -2,268 +2,374 @@
 #include <android/log.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
+#include <php_variables.h>
 
 #define LOG_TAG "PHP-Native"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-static php_stream *g_stdout_stream = NULL;
-extern void pipe_php_output(const char* str);
 
-void initialize_php_with_request(const char *post_data, const char *method, const char *uri, const char *content_type) {
-    LOGI("🛠️ Starting PHP request startup");
-    LOGI("🐛 initialize_php_with_request called with method=%s uri=%s ct=%s", method, uri, content_type ? content_type : "NULL");
+// Android SAPI callbacks
+// Every callback reads the bridge_request attached to the current interpreter
+// (bridge_ctx()->request), so nothing about a request goes through the process
+// environment and concurrent interpreters never see each other's data.
 
-    // Step 0: Pre-fill SG(request_info) BEFORE startup
-    // This is CRITICAL for session persistence so PHP sees the cookie during startup
-    SG(request_info).request_method = method;
-    SG(request_info).request_uri = (char*)uri;
-    SG(request_info).content_type = (char*)content_type;
-    SG(request_info).content_length = post_data ? strlen(post_data) : 0;
-    SG(request_info).proto_num = 1001; // HTTP/1.1
+static bridge_request *current_request() {
+    return bridge_ctx()->request;
+}
 
-    const char* cookie_header = getenv("HTTP_COOKIE");
-    if (cookie_header) {
-        SG(request_info).cookie_data = (char*)cookie_header;
-        LOGI("🍪 Pre-set SG(request_info).cookie_data: %s", cookie_header);
-    } else {
-        LOGI("🚫 No HTTP_COOKIE found in environment for SG setup");
-    }
+// Read the request body for sapi_read_post_data()/php://input
+static size_t android_read_post(char *buffer, size_t count_bytes) {
+    bridge_request *req = current_request();
+    if (!req || !req->body || req->body_offset >= req->body_length) return 0;
 
-    // Step 1: Bootstrap PHP internals (superglobals, session, etc)
-    if (php_request_startup() == FAILURE) {
-        LOGE("❌ php_request_startup() failed");
-        php_module_shutdown();
-        return;
-    }
-    LOGI("✅ php_request_startup() completed");
+    size_t remaining = req->body_length - req->body_offset;
+    size_t n = count_bytes < remaining ? count_bytes : remaining;
+    memcpy(buffer, req->body + req->body_offset, n);
+    req->body_offset += n;
+    return n;
+}
 
-    // Step 2: Populate $_SERVER
-    zval server_array;
-    array_init(&server_array);
-
-    add_assoc_string(&server_array, "REQUEST_METHOD", (char*)method);
-    add_assoc_string(&server_array, "REQUEST_URI", (char*)uri);
-    add_assoc_string(&server_array, "SCRIPT_NAME", "/mobile_boot.php");
-    add_assoc_string(&server_array, "SCRIPT_FILENAME", "/mobile_boot.php");
-    add_assoc_string(&server_array, "SERVER_PROTOCOL", "HTTP/1.1");
-    add_assoc_string(&server_array, "SERVER_NAME", "127.0.0.1");
-    add_assoc_string(&server_array, "SERVER_PORT", "80");
-    add_assoc_string(&server_array, "REMOTE_ADDR", "127.0.0.1");
-    add_assoc_string(&server_array, "PHP_SELF", "/mobile_boot.php");
-    add_assoc_string(&server_array, "REQUEST_SCHEME", "http");
-    add_assoc_string(&server_array, "HTTP_HOST", "127.0.0.1");
-    add_assoc_string(&server_array, "HTTPS", "off");
-    add_assoc_string(&server_array, "HTTP_USER_AGENT", "PHPNative/1.0");
-    add_assoc_long(&server_array, "REQUEST_TIME", time(NULL));
-
-    zend_hash_str_update(&EG(symbol_table), "_SERVER", sizeof("_SERVER") - 1, &server_array);
-    LOGI("✅ $_SERVER populated");
-
-    // Step 3: Populate $_COOKIE manually (backup/ensure)
-    // Even though we set cookie_data, we manually ensure _COOKIE is populated correctly
-    if (cookie_header) {
-        zval cookie_array;
-        array_init(&cookie_array);
-
-        char* cookies = strdup(cookie_header);
-        char* token = strtok(cookies, ";");
-        while (token) {
-            while (*token == ' ') token++;
-            char* equal = strchr(token, '=');
-            if (equal) {
-                *equal = '\0';
-                const char* key = token;
-                const char* val = equal + 1;
-                // LOGI("🍪 Parsed cookie → %s = %s", key, val);
-                add_assoc_string(&cookie_array, key, val);
-            }
-            token = strtok(NULL, ";");
-        }
-        free(cookies);
+static char *android_read_cookies(void) {
+    bridge_request *req = current_request();
+    return req ? (char *) req->cookie : NULL;
+}
 
-        zend_hash_str_update(&EG(symbol_table), "_COOKIE", sizeof("_COOKIE") - 1, &cookie_array);
-        LOGI("✅ $_COOKIE manually populated from HTTP_COOKIE");
+// Look up a request header by its CGI name (HTTP_ACCEPT_LANGUAGE -> Accept-Language)
+static const char *request_header_by_cgi_name(bridge_request *req, const char *name, size_t name_len) {
+    if (name_len <= 5 || strncmp(name, "HTTP_", 5) != 0) return NULL;
+
+    const char *wanted = name + 5;
+    size_t wanted_len = name_len - 5;
+    for (size_t i = 0; i < req->header_count; i++) {
+        const char *h = req->header_names[i];
+        size_t j = 0;
+        for (; j < wanted_len && h[j]; j++) {
+            char c = (h[j] == '-') ? '_' : (char) toupper((unsigned char) h[j]);
+            if (c != wanted[j]) break;
+        }
+        if (j == wanted_len && h[j] == '\0') return req->header_values[i];
     }
+    return NULL;
+}
 
-    // Step 4: Setup PHP output buffer (stdout stream)
-    LOGI("🌀 Setting up memory output stream");
-    g_stdout_stream = php_stream_memory_create(TEMP_STREAM_DEFAULT);
-    if (!g_stdout_stream) {
-        LOGE("❌ Failed to create STDOUT memory stream");
-        return;
+// Console values of a runner command. Used to be setenv()ed for the whole
+// process; now they only exist while the command's request runs.
+static const char *runner_vars[][2] = {
+    {"APP_RUNNING_IN_CONSOLE", "true"},
+    {"APP_ENV", "local"},
+    {"PHP_SELF", "runner"},
+};
+#define RUNNER_VAR_COUNT (sizeof(runner_vars) / sizeof(runner_vars[0]))
+
+// getenv() for request variables; anything else falls through to the real environment
+static char *android_getenv(const char *name, size_t name_len) {
+    bridge_request *req = current_request();
+    if (!req) {
+        if (!bridge_ctx()->runner) return NULL;
+        for (size_t i = 0; i < RUNNER_VAR_COUNT; i++) {
+            if (strcmp(name, runner_vars[i][0]) == 0) return (char *) runner_vars[i][1];
+        }
+        return NULL;
     }
 
-    zend_string *stdout_name = zend_string_init("STDOUT", sizeof("STDOUT") - 1, 0);
-    zval stdout_handle;
-    php_stream_to_zval(g_stdout_stream, &stdout_handle);
-    zend_hash_add(&EG(symbol_table), stdout_name, &stdout_handle);
-    zend_string_release(stdout_name);
-    LOGI("✅ STDOUT memory stream ready");
+    if (strcmp(name, "REQUEST_METHOD") == 0) return (char *) req->method;
+    if (strcmp(name, "REQUEST_URI") == 0) return (char *) req->uri;
+    if (strcmp(name, "QUERY_STRING") == 0) return (char *) (req->query_string ? req->query_string : "");
+    if (strcmp(name, "CONTENT_TYPE") == 0) return (char *) req->content_type;
+    if (strcmp(name, "CONTENT_LENGTH") == 0) return req->body ? req->content_length : NULL;
+    if (strcmp(name, "HTTP_COOKIE") == 0) return (char *) req->cookie;
 
-    php_output_activate();
+    return (char *) request_header_by_cgi_name(req, name, name_len);
+}
 
-    // Step 5: Setup POST/PATCH/PUT body if needed
-    if (post_data) {
-        size_t post_data_length = strlen(post_data);
+// $_SERVER template: the process environment (app config exported by
+// MobileEnvironment) followed by the fixed loopback server values. Built once
+// at module startup with permanent interned keys and values, so a request only
+// pays for one zend_array_dup() plus the slots that actually change. Lives in
+// persistent memory and is never written after startup.
+//
+// Variables set through nativeSetEnv after startup are listed in
+// server_overrides and read from the environment on top of the template. The
+// list is written under the exclusive engine lock and read by requests under
+// the shared one. Past SERVER_OVERRIDES_MAX names the template goes stale and
+// requests import the whole environment until the next engine start.
+#define SERVER_OVERRIDES_MAX 32
+
+static HashTable *server_template = NULL;
+static int server_template_stale = 0;
+static char *server_overrides[SERVER_OVERRIDES_MAX];
+static size_t server_override_count = 0;
+
+enum { SV_REQUEST_METHOD, SV_REQUEST_URI, SV_QUERY_STRING, SV_CONTENT_TYPE, SV_CONTENT_LENGTH, SV_COUNT };
+static zend_string *server_keys[SV_COUNT];
+
+extern char **environ;
+
+static const char *server_fixed[][2] = {
+    {"SCRIPT_NAME", "/mobile_boot.php"},
+    {"SCRIPT_FILENAME", "/mobile_boot.php"},
+    {"PHP_SELF", "/mobile_boot.php"},
+    {"SERVER_PROTOCOL", "HTTP/1.1"},
+    {"SERVER_NAME", "127.0.0.1"},
+    {"SERVER_PORT", "80"},
+    {"REMOTE_ADDR", "127.0.0.1"},
+    {"REQUEST_SCHEME", "http"},
+    {"HTTP_HOST", "127.0.0.1"},
+    {"HTTPS", "off"},
+    {"HTTP_USER_AGENT", "PHPNative/1.0"},
+};
+#define SERVER_FIXED_COUNT (sizeof(server_fixed) / sizeof(server_fixed[0]))
+
+static void template_set(const char *name, size_t name_len, const char *value, size_t value_len) {
+    zval zv;
+    zend_string *key = zend_string_init_interned(name, name_len, 1);
+    ZVAL_INTERNED_STR(&zv, zend_string_init_interned(value, value_len, 1));
+    zend_symtable_update(server_template, key, &zv);
+}
+
+static void server_overrides_clear(void) {
+    for (size_t i = 0; i < server_override_count; i++) {
+        free(server_overrides[i]);
+    }
+    server_override_count = 0;
+}
 
-        LOGI("📮 Detected POST request");
-        LOGI("📦 POST body length: %zu", post_data_length);
+/**
+ * Build the $_SERVER template. Must run during module startup (nativephp
+ * MINIT): permanent interned strings can only be created before the engine
+ * switches to request-interned storage.
+ */
+void android_server_template_startup(void) {
+    server_template = pemalloc(sizeof(HashTable), 1);
+    zend_hash_init(server_template, 64, NULL, NULL, 1);
+
+    for (char **e = environ; e && *e; e++) {
+        const char *eq = strchr(*e, '=');
+        if (!eq || eq == *e) continue;
+        template_set(*e, eq - *e, eq + 1, strlen(eq + 1));
+    }
+    for (size_t i = 0; i < SERVER_FIXED_COUNT; i++) {
+        template_set(server_fixed[i][0], strlen(server_fixed[i][0]), server_fixed[i][1], strlen(server_fixed[i][1]));
+    }
 
-        php_stream *mem_stream = php_stream_memory_create(TEMP_STREAM_DEFAULT);
-        php_stream_write(mem_stream, post_data, post_data_length);
+    server_keys[SV_REQUEST_METHOD] = zend_string_init_interned(ZEND_STRL("REQUEST_METHOD"), 1);
+    server_keys[SV_REQUEST_URI] = zend_string_init_interned(ZEND_STRL("REQUEST_URI"), 1);
+    server_keys[SV_QUERY_STRING] = zend_string_init_interned(ZEND_STRL("QUERY_STRING"), 1);
+    server_keys[SV_CONTENT_TYPE] = zend_string_init_interned(ZEND_STRL("CONTENT_TYPE"), 1);
+    server_keys[SV_CONTENT_LENGTH] = zend_string_init_interned(ZEND_STRL("CONTENT_LENGTH"), 1);
 
-        SG(request_info).request_body = mem_stream;
-        // content_length/type already set in Step 0
+    server_overrides_clear();
+    __atomic_store_n(&server_template_stale, 0, __ATOMIC_RELEASE);
+    LOGI("🧩 $_SERVER template ready (%u entries)", zend_hash_num_elements(server_template));
+}
 
-        // Fallback logic from previous working build
-        // If content_type is missing OR if it's not JSON, force application/x-www-form-urlencoded
-        // This ensures traditional forms (which might miss the header or be generic) are parsed correctly
-        if (content_type && strstr(content_type, "json")) {
-            SG(request_info).content_type = "application/json";
-        } else {
-            // Force urlencoded for everything else (traditional forms)
-            SG(request_info).content_type = "application/x-www-form-urlencoded";
-            LOGI("📄 Enforcing application/x-www-form-urlencoded (Old Build Behavior)");
-        }
+void android_server_template_shutdown(void) {
+    if (!server_template) return;
+    zend_hash_destroy(server_template);
+    pefree(server_template, 1);
+    server_template = NULL;
+    memset(server_keys, 0, sizeof(server_keys));
+    server_overrides_clear();
+}
 
-        // Re-fetch content_type from SG as we might have changed it
-        content_type = SG(request_info).content_type;
+// Environment variable name changed after startup (nativeSetEnv); the caller
+// holds the engine lock exclusively
+void android_server_template_override(const char *name) {
+    if (!server_template) return;   // the next startup reads the whole environment
 
-        // Populate $_POST for urlencoded forms (fallback to method if content-type missing)
-        if ((content_type && strstr(content_type, "application/x-www-form-urlencoded")) ||
-            (strcmp(method, "POST") == 0 || strcmp(method, "PUT") == 0 || strcmp(method, "PATCH") == 0)) {
-            sapi_module.treat_data(PARSE_POST, (char*)post_data, NULL);
-            LOGI("✅ Parsed POST form data into $_POST");
-        }
+    for (size_t i = 0; i < server_override_count; i++) {
+        if (strcmp(server_overrides[i], name) == 0) return;
     }
 
-    // Finalize request startup state (redundant but safe)
-    PG(during_request_startup) = 0;
-    EG(exit_status) = 0;
+    char *copy = server_override_count < SERVER_OVERRIDES_MAX ? strdup(name) : NULL;
+    if (!copy) {
+        __atomic_store_n(&server_template_stale, 1, __ATOMIC_RELEASE);
+        return;
+    }
+    server_overrides[server_override_count++] = copy;
 }
 
+static void server_set(zval *track_vars_array, int slot, const char *name, const char *value) {
+    if (!server_keys[slot]) {
+        php_register_variable_safe(name, value, strlen(value), track_vars_array);
+        return;
+    }
+
+    zval zv;
+    ZVAL_STRING(&zv, value);
+    zend_hash_update(Z_ARRVAL_P(track_vars_array), server_keys[slot], &zv);
+}
 
-// Add this new function to read output from the stdout stream
-// Function to capture stdout content after PHP execution
-void capture_php_stdout_output() {
-    if (!g_stdout_stream) {
-        LOGI("No stdout stream to capture");
+// Build $_SERVER: process environment first (app config exported by
+// MobileEnvironment), then the fixed loopback server values, then this request.
+// Outside a request this behaves like the stock embed SAPI, plus the console
+// values while a runner command runs.
+static void android_register_variables(zval *track_vars_array) {
+    bridge_request *req = current_request();
+
+    if (!req) {
+        php_import_environment_variables(track_vars_array);
+        if (bridge_ctx()->runner) {
+            for (size_t i = 0; i < RUNNER_VAR_COUNT; i++) {
+                php_register_variable_safe(runner_vars[i][0], runner_vars[i][1], strlen(runner_vars[i][1]), track_vars_array);
+            }
+        }
         return;
     }
 
-    // Flush the stream to make sure all data is in memory
-    php_stream_flush(g_stdout_stream);
+    if (server_template && !__atomic_load_n(&server_template_stale, __ATOMIC_ACQUIRE)) {
+        zval_ptr_dtor(track_vars_array);
+        ZVAL_ARR(track_vars_array, zend_array_dup(server_template));
+
+        for (size_t i = 0; i < server_override_count; i++) {
+            const char *value = getenv(server_overrides[i]);
+            if (value) {
+                php_register_variable_safe(server_overrides[i], value, strlen(value), track_vars_array);
+            }
+        }
+    } else {
+        php_import_environment_variables(track_vars_array);
+        for (size_t i = 0; i < SERVER_FIXED_COUNT; i++) {
+            php_register_variable_safe(server_fixed[i][0], server_fixed[i][1], strlen(server_fixed[i][1]), track_vars_array);
+        }
+    }
 
-    // Get the length of data in the stream
-    php_stream_seek(g_stdout_stream, 0, SEEK_END);
-    size_t size = php_stream_tell(g_stdout_stream);
+    server_set(track_vars_array, SV_REQUEST_METHOD, "REQUEST_METHOD", req->method);
+    server_set(track_vars_array, SV_REQUEST_URI, "REQUEST_URI", req->uri);
+    server_set(track_vars_array, SV_QUERY_STRING, "QUERY_STRING", req->query_string ? req->query_string : "");
+    if (req->content_type) {
+        server_set(track_vars_array, SV_CONTENT_TYPE, "CONTENT_TYPE", req->content_type);
+    }
+    if (req->body) {
+        server_set(track_vars_array, SV_CONTENT_LENGTH, "CONTENT_LENGTH", req->content_length);
+    }
 
-    if (size > 0) {
-        // Allocate buffer for the data
-        char *buffer = (char*)malloc(size + 1);
-        if (buffer) {
-            // Rewind to beginning
-            php_stream_rewind(g_stdout_stream);
+    // Request headers as HTTP_*; Content-Type/Length follow the CGI names above
+    char name[256];
+    for (size_t i = 0; i < req->header_count; i++) {
+        const char *h = req->header_names[i];
+        if (strcasecmp(h, "Content-Type") == 0 || strcasecmp(h, "Content-Length") == 0) continue;
 
-            // Read all data
-            size_t bytes_read = php_stream_read(g_stdout_stream, buffer, size);
-            buffer[bytes_read] = '\0';
+        size_t n = 0;
+        memcpy(name, "HTTP_", 5);
+        for (n = 5; *h && n < sizeof(name) - 1; h++, n++) {
+            name[n] = (*h == '-') ? '_' : (char) toupper((unsigned char) *h);
+        }
+        name[n] = '\0';
+        php_register_variable_safe(name, req->header_values[i], strlen(req->header_values[i]), track_vars_array);
+    }
+}
 
-            LOGI("Captured %zu bytes from stdout stream", bytes_read);
+// Module startup with the nativephp extension (nativephp_call/nativephp_can)
+// registered next to the built-ins. php_embed_init() overwrites
+// additional_functions, so the extension goes in through startup instead.
+static int android_sapi_startup(sapi_module_struct *module) {
+    return php_module_startup(module, &nativephp_module_entry);
+}
 
-            // Send to our output collector
-            pipe_php_output(buffer);
+void android_sapi_install(sapi_module_struct *module) {
+    module->startup = android_sapi_startup;
+    module->register_server_variables = android_register_variables;
+    module->read_post = android_read_post;
+    module->read_cookies = android_read_cookies;
+    module->getenv = android_getenv;
+}
 
-            free(buffer);
+/**
+ * Pre-fill SG(request_info) for the upcoming request.
+ *
+ * Must run BEFORE php_request_startup()/sapi_activate(). A non-NULL
+ * server_context is what makes sapi_activate() call read_cookies and read
+ * the POST body through read_post.
+ */
+void prime_request_info(bridge_request *req) {
+    bridge_ctx()->request = req;
+
+    if (req->body_length == 0) req->body = NULL;
+    snprintf(req->content_length, sizeof(req->content_length), "%zu", req->body_length);
+    req->body_offset = 0;
+
+    // Keep the old bridge behaviour: bodies that are not JSON are treated as
+    // urlencoded forms, even when the WebView sent no Content-Type
+    if (req->body) {
+        if (!(req->content_type && strstr(req->content_type, "json"))) {
+            req->content_type = "application/x-www-form-urlencoded";
         }
-    } else {
-        LOGI("Stdout stream is empty");
     }
+
+    SG(server_context) = req;
+    SG(request_info).request_method = req->method;
+    SG(request_info).request_uri = (char *) req->uri;
+    SG(request_info).query_string = (char *) req->query_string;
+    SG(request_info).content_type = req->content_type;
+    SG(request_info).content_length = (zend_long) req->body_length;
+    SG(request_info).proto_num = 1001; // HTTP/1.1
+    SG(request_info).cookie_data = (char *) req->cookie;
 }
 
-// Helper to write headers to the output stream
-static void android_send_header(sapi_header_struct *sapi_header, void *server_context) {
-    if (sapi_header && g_stdout_stream) {
-        // LOGI("📤 Sending header: %s", sapi_header->header);
-        php_stream_write(g_stdout_stream, sapi_header->header, strlen(sapi_header->header));
-        php_stream_write(g_stdout_stream, "\r\n", 2);
+/**
+ * Finish superglobals for the current request.
+ *
+ * $_GET, $_POST and $_COOKIE come from the SAPI callbacks during
+ * php_hash_environment(); this only forces $_SERVER to be rebuilt (it is a
+ * JIT global, so a resident worker would otherwise keep the old one) and
+ * parses urlencoded PUT/PATCH bodies, which PHP leaves alone.
+ */
+void populate_request_globals(bridge_request *req) {
+    zend_is_auto_global_str(ZEND_STRL("_SERVER"));
+
+    if (req->body && req->body_length > 0 && strcmp(req->method, "POST") != 0 &&
+        strstr(req->content_type, "application/x-www-form-urlencoded")) {
+        zval *post = zend_hash_str_find(&EG(symbol_table), "_POST", sizeof("_POST") - 1);
+        if (post && Z_TYPE_P(post) == IS_ARRAY) {
+            sapi_module.treat_data(PARSE_STRING, estrndup(req->body, req->body_length), post);
+            LOGI("✅ Parsed %s form data into $_POST", req->method);
+        }
     }
 }
 
-// Helper to send all headers including status line
-static int android_send_headers(sapi_headers_struct *sapi_headers) {
-    if (!g_stdout_stream) return SAPI_HEADER_SEND_FAILED;
+void initialize_php_with_request(bridge_request *req) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    LOGI("🛠️ Starting PHP request startup");
+    LOGI("🐛 initialize_php_with_request called with method=%s uri=%s ct=%s", req->method, req->uri, req->content_type ? req->content_type : "NULL");
+
+    uint64_t t = bridge_now_ns();
 
-    char buf[1024];
-    // Simple status line construction
-    int response_code = SG(sapi_headers).http_response_code;
-    if (response_code == 0) response_code = 200;
+    // Step 0: Pre-fill SG(request_info) BEFORE startup
+    prime_request_info(req);
+
+    // Step 1: Bootstrap PHP internals (superglobals, session, etc)
+    if (php_request_startup() == FAILURE) {
+        LOGE("❌ php_request_startup() failed");
+        php_module_shutdown();
+        return;
+    }
+    LOGI("✅ php_request_startup() completed");
 
-    // Note: We could map status codes to text (e.g. 200 OK, 404 Not Found),
-    // but for now "OK" or just the code is often sufficient for the bridge parser
-    // which primarily looks at the code.
-    // However, proper HTTP requires a reason phrase.
-    const char* reason = "OK";
-    if (response_code == 302) reason = "Found";
-    else if (response_code == 404) reason = "Not Found";
-    else if (response_code == 500) reason = "Internal Server Error";
+    // Step 2: Setup PHP output buffer (stdout stream)
+    LOGI("🌀 Setting up memory output stream");
+    ctx->stdout_stream = php_stream_memory_create(TEMP_STREAM_DEFAULT);
+    if (!ctx->stdout_stream) {
+        LOGE("❌ Failed to create STDOUT memory stream");
+        return;
+    }
 
-    snprintf(buf, sizeof(buf), "HTTP/1.1 %d %s\r\n", response_code, reason);
-    php_stream_write(g_stdout_stream, buf, strlen(buf));
+    zend_string *stdout_name = zend_string_init("STDOUT", sizeof("STDOUT") - 1, 0);
+    zval stdout_handle;
+    php_stream_to_zval(ctx->stdout_stream, &stdout_handle);
+    zend_hash_add(&EG(symbol_table), stdout_name, &stdout_handle);
+    zend_string_release(stdout_name);
+    LOGI("✅ STDOUT memory stream ready");
 
-    // Iterate and send all headers
-    zend_llist_apply_with_argument(&SG(sapi_headers).headers,
-                                   (llist_apply_with_arg_func_t) android_send_header,
-                                   NULL);
+    php_output_activate();
+    t = bridge_metrics_mark(BRIDGE_PHASE_STARTUP, t);
 
-    // End of headers section
-    php_stream_write(g_stdout_stream, "\r\n", 2);
+    // Step 3: $_SERVER and PUT/PATCH form bodies
+    populate_request_globals(req);
+    bridge_metrics_mark(BRIDGE_PHASE_GLOBALS, t);
 
-    return SAPI_HEADER_SENT_SUCCESSFULLY;
+    // Finalize request startup state (redundant but safe)
+    PG(during_request_startup) = 0;
+    EG(exit_status) = 0;
 }
-
-static sapi_module_struct php_module = {
-        "android",                     // name
-        "Android Embedded PHP",        // pretty name
-
-        NULL,                         // startup
-        php_module_shutdown_wrapper,   // shutdown
-
-        NULL,                         // activate
-        NULL,                         // deactivate
-
-        capture_php_output,           // unbuffered write
-        NULL,                         // flush
-        NULL,                         // get uid
-        NULL,                         // getenv
-
-        NULL,                         // sapi error handler
-        NULL,                         // header handler
-        android_send_headers,         // send headers handler
-        android_send_header,          // send header handler
-
-        NULL,                         // read POST data
-        NULL,                         // read Cookies
-
-        NULL,                         // register server variables
-        NULL,                         // log message
-        NULL,                         // get request time
-        NULL,                         // terminate process
-
-        NULL,                         // php_ini_path_override
-        NULL,                         // default_post_reader
-        NULL,                         // treat_data
-        NULL,                         // executable_location
-
-        0,                           // php_ini_ignore
-        0,                           // php_ini_ignore_cwd
-        NULL,                         // get_fd
-        NULL,                         // force_http_10
-        NULL,                         // get_target_uid
-        NULL,                         // get_target_gid
-        NULL,                         // input_filter
-        NULL,                         // ini_defaults
-        0,                           // phpinfo_as_text
-        NULL,                         // ini_entries
-        NULL                          // additional_functions
-};
@@ -1,17 +1,246 @@
 #ifndef PHP_BRIDGE_H
 #define PHP_BRIDGE_H
 
+#include <jni.h>
 #include "php_embed.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * One HTTP request as handed over by Kotlin.
+ *
+ * Read by the Android SAPI callbacks (register_server_variables, read_post,
+ * read_cookies, getenv) instead of the process environment. All strings are
+ * owned by the request and live until bridge_request_free().
+ */
+typedef struct bridge_request {
+    const char *method;
+    const char *uri;
+    const char *query_string;   // points into uri, NULL when empty
+    const char *content_type;
+    const char *cookie;
+    const char *script_path;
+
+    const char *body;
+    size_t body_length;
+    size_t body_offset;         // read_post cursor
+    char content_length[24];
+
+    size_t header_count;
+    const char **header_names;
+    const char **header_values;
+} bridge_request;
+
+/**
+ * Request phases timed by bridge_metrics.c. Compile time is measured by the
+ * zend_compile_file hook; execute excludes compile and output time spent
+ * while the script ran.
+ */
+typedef enum bridge_phase {
+    BRIDGE_PHASE_STARTUP,    // php_request_startup / SAPI + output re-activation
+    BRIDGE_PHASE_GLOBALS,    // superglobals ($_GET/$_POST/$_COOKIE/$_SERVER)
+    BRIDGE_PHASE_COMPILE,
+    BRIDGE_PHASE_EXECUTE,
+    BRIDGE_PHASE_OUTPUT,     // ub_write: buffer copy or pipe write
+    BRIDGE_PHASE_SHUTDOWN,
+    BRIDGE_PHASE_COUNT
+} bridge_phase;
+
+// One finished (or in-flight) request as recorded in the metrics ring
+typedef struct bridge_metrics {
+    uint64_t id;
+    int64_t started_at_ms;      // wall clock
+    char method[8];
+    char uri[128];
+    int status;
+    int worker;                 // served by the resident worker
+    uint64_t phase_ns[BRIDGE_PHASE_COUNT];
+    uint64_t total_ns;
+    size_t peak_memory;         // zend_memory_peak_usage() for this request
+    size_t heap_size;           // Zend MM heap kept by the interpreter once the request finished
+    size_t bytes_out;
+} bridge_metrics;
+
+/**
+ * Per-interpreter request state.
+ *
+ * NTS builds of libphp have exactly one interpreter, so a single context is
+ * shared. ZTS builds give every interpreter thread its own context so parallel
+ * requests never write into each other's output or header buffers.
+ */
+typedef struct bridge_request_ctx {
+    char *output;
+    size_t output_length;
+    size_t output_capacity;
+
+    // Response head, captured from SG(sapi_headers) at send_headers:
+    // headers holds header_count "name\0value\0" pairs
+    int status_code;
+    char *headers;
+    size_t header_length;
+    size_t header_capacity;
+    size_t header_count;
+
+    php_stream *stdout_stream;
+    bridge_request *request;
+
+    // Streaming mode: body bytes go straight to stream_fd (a pipe read by the
+    // WebView) and the head is handed to stream_sink.onHeaders() once known
+    int streaming;
+    int stream_fd;
+    int stream_head_sent;
+    JNIEnv *stream_env;
+    jobject stream_sink;
+
+    int worker_booted;
+    zval worker_handler;
+
+    // Set while a runner command executes (console $_SERVER/getenv values)
+    int runner;
+
+    // Metrics of the request in flight (bridge_metrics.c)
+    bridge_metrics metrics;
+    uint64_t metrics_start_ns;
+    uint64_t execute_start_ns;
+    uint64_t execute_excluded_ns;   // compile + output already counted at execute start
+
+    // Function profiler state, allocated on first profiled request (bridge_profiler.c)
+    struct bridge_profile *profile;
+
+    // Sampling profiler registration, 1-based; 0 until first sampled (bridge_sampler.c)
+    int sampler_slot;
+
+    // Request watchdog registration, 1-based; 0 until first armed (bridge_watchdog.c)
+    int watchdog_slot;
+
+    // File named by an X-Sendfile response header, sent by the bridge (bridge_sendfile.c)
+    int sendfile_active;
+    int sendfile_fd;
+    off_t sendfile_offset;
+    size_t sendfile_length;
+    char *sendfile_path;
+
+    // X-Bridge-Cache directive of the response, until it is stored (bridge_cache.c)
+    char *cache_directive;
+
+    // Last onTrimMemory round this interpreter settled (php_bridge.c)
+    unsigned int trim_round;
+
+    unsigned int engine_generation;
+    int thread_attached;
+} bridge_request_ctx;
+
+bridge_request_ctx *bridge_ctx(void);
+int bridge_max_interpreters(void);
+
 typedef void (*phpOutputCallback)(const char* output);
 void override_embed_module_output(phpOutputCallback callback);
-void initialize_php_with_request(const char* post_data, const char* method, const char* uri, const char* content_type);
+void android_sapi_install(sapi_module_struct *module);
+void initialize_php_with_request(bridge_request *req);
+void prime_request_info(bridge_request *req);
+void populate_request_globals(bridge_request *req);
+void android_server_template_startup(void);
+void android_server_template_shutdown(void);
+void android_server_template_override(const char *name);
 size_t capture_php_output(const char *str, size_t str_length);
 
+// Request metrics (bridge_metrics.c)
+#define BRIDGE_METRICS_RING 64
+
+uint64_t bridge_now_ns(void);
+const char *bridge_phase_name(bridge_phase phase);
+void bridge_metrics_startup(void);
+void bridge_metrics_shutdown(void);
+void bridge_metrics_begin(bridge_request *req, int worker);
+uint64_t bridge_metrics_mark(bridge_phase phase, uint64_t since_ns);
+void bridge_metrics_output(size_t length, uint64_t since_ns);
+void bridge_metrics_execute_begin(void);
+void bridge_metrics_execute_end(void);
+void bridge_metrics_capture_memory(void);
+void bridge_metrics_end(void);
+size_t bridge_metrics_snapshot(bridge_metrics *out, size_t max);
+size_t bridge_metrics_server_timing(const bridge_metrics *m, int final, char *buf, size_t size);
+char *bridge_metrics_json(void);
+
+// Function profiler (bridge_profiler.c); opt-in with MVC_PROFILER=1 at engine start
+int bridge_profiler_enabled(void);
+void bridge_profiler_startup(void);
+void bridge_profiler_begin(void);
+void bridge_profiler_end(const bridge_metrics *m);
+char *bridge_profiler_last(void);
+void bridge_function_name(const zend_function *func, char *buf, size_t size);
+
+// Sampling profiler (bridge_sampler.c); opt-in with MVC_SAMPLER=1 at engine start
+int bridge_sampler_enabled(void);
+void bridge_sampler_startup(void);
+void bridge_sampler_shutdown(void);
+void bridge_sampler_begin(bridge_request *req);
+void bridge_sampler_end(void);
+char *bridge_sampler_folded(int reset);
+
+// Request watchdog (bridge_watchdog.c); MVC_REQUEST_TIMEOUT_MS at engine start
+void bridge_watchdog_startup(void);
+void bridge_watchdog_shutdown(void);
+void bridge_watchdog_arm(bridge_request *req);
+int bridge_watchdog_extend(uint64_t timeout_ms);
+int64_t bridge_watchdog_remaining_ms(void);
+int bridge_watchdog_interrupted(void);
+int bridge_watchdog_disarm(uint64_t *elapsed_ms);
+
+// File responses (bridge_sendfile.c)
+int bridge_sendfile_header(const char *name, size_t name_length, const char *value, size_t value_length);
+void bridge_sendfile_resolve(void);
+int bridge_sendfile_detach(off_t *offset, size_t *length);
+void bridge_sendfile_pipe(int out_fd);
+void bridge_sendfile_reset(void);
+
+// Response cache (bridge_cache.c); MVC_RESPONSE_CACHE_MB at engine start
+typedef struct bridge_cached_response {
+    int status;
+    uint64_t age_s;
+    size_t header_count;
+    const char *headers;        // "name\0value\0" pairs
+    const char *body;
+    size_t body_length;
+    const char *file;           // X-Sendfile path instead of a body, or NULL
+    off_t file_size;            // file size and mtime when it was cached
+    int64_t file_mtime_ns;
+} bridge_cached_response;
+
+void bridge_cache_startup(void);
+void bridge_cache_shutdown(void);
+int bridge_cache_header(const char *name, size_t name_length, const char *value, size_t value_length);
+void bridge_cache_directive_reset(void);
+void bridge_cache_store(const bridge_request *req, const char *body, size_t body_length, const char *file);
+bridge_cached_response *bridge_cache_fetch(const bridge_request *req);
+void bridge_cache_evict(const bridge_request *req);
+size_t bridge_cache_forget(const char *const *tags, size_t count);
+
+// Context.getDir("storage"), resolved once (php_bridge.c)
+const char *bridge_storage_dir(JNIEnv *env, jobject bridge);
+
+// Static assets (bridge_assets.c)
+JNIEXPORT jlongArray JNICALL native_open_asset(JNIEnv *env, jobject thiz, jstring path);
+JNIEXPORT void JNICALL native_invalidate_assets(JNIEnv *env, jobject thiz);
+
+// nativephp extension (nativephp_extension.c)
+extern zend_module_entry nativephp_module_entry;
+int nativephp_jni_init(JNIEnv *env);
+
+// Kotlin bridge registry (bridge_jni.cpp)
+typedef void (*NativePHPResultSink)(void *target, const char *data, size_t length);
+JNIEnv *NativeBridgeEnv(void);
+int NativePHPCan(const char *functionName);
+int NativePHPCall(const char *functionName, const char *parametersJSON,
+                  NativePHPResultSink sink, void *target);
+jobject NativePHPCallMap(JNIEnv *env, const char *functionName, jobject parameters);
+jobject NativePHPCallMany(JNIEnv *env, jobject calls);
+jlong NativePHPCallAsync(JNIEnv *env, const char *functionName, jobject parameters);
+jlong NativePHPAwait(JNIEnv *env, const jlong *tickets, size_t count, jlong timeoutMs);
+jobject NativePHPResult(JNIEnv *env, jlong ticket);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,222 @@
+#include <android/log.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "PHP.h"
+
+#define LOG_TAG "PHP-Assets"
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
+
+// Static assets
+// PHPWebViewClient asks nativeOpenAsset() for every CSS/JS/font/image URL. The
+// path is looked up in public/, public/vendor/, public/build/ and, for
+// storage/..., the persisted storage directory, the same order the Kotlin
+// probe used. The file that matched is remembered (positive cache) and so is a
+// path that matched nothing (negative cache, for ASSET_MISS_TTL_MS, since
+// storage files appear at runtime). A hit costs one open() + fstat(); the
+// WebView reads straight from the returned fd.
+
+#define ASSET_BUCKETS 512
+#define ASSET_MAX_ENTRIES 2048
+#define ASSET_MISS_TTL_MS 10000
+#define ASSET_PATH_MAX 1024
+
+typedef struct asset_entry {
+    struct asset_entry *next;
+    uint32_t hash;
+    char *resolved;             // absolute file path; NULL for a cached miss
+    uint64_t missed_at_ns;
+    char key[];
+} asset_entry;
+
+static asset_entry *g_buckets[ASSET_BUCKETS];
+static size_t g_entry_count = 0;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char g_public_root[ASSET_PATH_MAX];
+static char g_storage_root[ASSET_PATH_MAX];
+
+static uint32_t hash_path(const char *path) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *) path; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+static void cache_clear_locked(void) {
+    for (size_t i = 0; i < ASSET_BUCKETS; i++) {
+        asset_entry *e = g_buckets[i];
+        while (e) {
+            asset_entry *next = e->next;
+            free(e->resolved);
+            free(e);
+            e = next;
+        }
+        g_buckets[i] = NULL;
+    }
+    g_entry_count = 0;
+}
+
+static asset_entry *cache_find_locked(const char *path, uint32_t hash) {
+    for (asset_entry *e = g_buckets[hash % ASSET_BUCKETS]; e; e = e->next) {
+        if (e->hash == hash && strcmp(e->key, path) == 0) return e;
+    }
+    return NULL;
+}
+
+// Remember path -> resolved (NULL = miss); the table is simply emptied when full
+static void cache_store(const char *path, const char *resolved) {
+    uint32_t hash = hash_path(path);
+
+    pthread_mutex_lock(&g_lock);
+    asset_entry *e = cache_find_locked(path, hash);
+    if (!e) {
+        if (g_entry_count >= ASSET_MAX_ENTRIES) cache_clear_locked();
+
+        size_t length = strlen(path);
+        e = calloc(1, sizeof(asset_entry) + length + 1);
+        if (!e) {
+            pthread_mutex_unlock(&g_lock);
+            return;
+        }
+        e->hash = hash;
+        memcpy(e->key, path, length + 1);
+        e->next = g_buckets[hash % ASSET_BUCKETS];
+        g_buckets[hash % ASSET_BUCKETS] = e;
+        g_entry_count++;
+    }
+
+    free(e->resolved);
+    e->resolved = resolved ? strdup(resolved) : NULL;
+    e->missed_at_ns = resolved ? 0 : bridge_now_ns();
+    pthread_mutex_unlock(&g_lock);
+}
+
+/**
+ * Cached outcome for path: 1 with the file in resolved, 0 for a recent miss,
+ * -1 when path is unknown (or its miss expired) and has to be probed.
+ */
+static int cache_lookup(const char *path, char *resolved, size_t size) {
+    uint32_t hash = hash_path(path);
+    int result = -1;
+
+    pthread_mutex_lock(&g_lock);
+    asset_entry *e = cache_find_locked(path, hash);
+    if (e && e->resolved) {
+        snprintf(resolved, size, "%s", e->resolved);
+        result = 1;
+    } else if (e && bridge_now_ns() - e->missed_at_ns < (uint64_t) ASSET_MISS_TTL_MS * 1000000ull) {
+        result = 0;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return result;
+}
+
+// Open a regular file read-only; -1 for anything else
+static int open_regular(const char *file, struct stat *st) {
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    if (fstat(fd, st) != 0 || !S_ISREG(st->st_mode)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Probe the candidate locations for path in order; returns an open fd or -1
+static int probe(const char *path, char *resolved, size_t size, struct stat *st) {
+    static const char *public_dirs[] = {"", "vendor/", "build/"};
+
+    for (size_t i = 0; i < sizeof(public_dirs) / sizeof(public_dirs[0]); i++) {
+        snprintf(resolved, size, "%s/%s%s", g_public_root, public_dirs[i], path);
+        int fd = open_regular(resolved, st);
+        if (fd >= 0) return fd;
+    }
+
+    if (strncmp(path, "storage/", 8) == 0) {
+        snprintf(resolved, size, "%s/%s", g_storage_root, path + 8);
+        int fd = open_regular(resolved, st);
+        if (fd >= 0) return fd;
+    }
+    return -1;
+}
+
+// Relative, no "..", no empty segment tricks: anything else never leaves the roots
+static int path_is_safe(const char *path) {
+    if (!*path || *path == '/') return 0;
+    for (const char *p = path; *p;) {
+        const char *end = strchr(p, '/');
+        size_t length = end ? (size_t) (end - p) : strlen(p);
+        if (length == 2 && p[0] == '.' && p[1] == '.') return 0;
+        if (!end) break;
+        p = end + 1;
+    }
+    return 1;
+}
+
+/**
+ * Resolve and open a static asset for PHPBridge.openAsset().
+ * path is relative to the public root, without query string. Returns
+ * long[] {fd, size, mtime ms} (the caller owns fd) or null when no file
+ * matches, in which case the request goes to PHP.
+ */
+JNIEXPORT jlongArray JNICALL native_open_asset(JNIEnv *env, jobject thiz, jstring jpath) {
+    if (!g_public_root[0]) {
+        const char *storage = bridge_storage_dir(env, thiz);
+        pthread_mutex_lock(&g_lock);
+        snprintf(g_public_root, sizeof(g_public_root), "%s/app/public", storage);
+        snprintf(g_storage_root, sizeof(g_storage_root), "%s/persisted_data/storage", storage);
+        pthread_mutex_unlock(&g_lock);
+    }
+
+    const char *path = (*env)->GetStringUTFChars(env, jpath, NULL);
+    if (!path) return NULL;
+
+    char resolved[ASSET_PATH_MAX];
+    struct stat st;
+    int fd = -1;
+
+    if (path_is_safe(path)) {
+        int cached = cache_lookup(path, resolved, sizeof(resolved));
+        if (cached == 1) {
+            fd = open_regular(resolved, &st);
+        }
+        // A cached file that went away, or a path not seen (recently): probe again
+        if (fd < 0 && cached != 0) {
+            fd = probe(path, resolved, sizeof(resolved), &st);
+            cache_store(path, fd >= 0 ? resolved : NULL);
+        }
+    }
+    (*env)->ReleaseStringUTFChars(env, jpath, path);
+
+    if (fd < 0) return NULL;
+
+    jlongArray result = (*env)->NewLongArray(env, 3);
+    if (!result) {
+        close(fd);
+        return NULL;
+    }
+    jlong values[3] = {
+        fd,
+        (jlong) st.st_size,
+        (jlong) st.st_mtim.tv_sec * 1000 + st.st_mtim.tv_nsec / 1000000
+    };
+    (*env)->SetLongArrayRegion(env, result, 0, 3, values);
+    return result;
+}
+
+// Forget every resolved path and miss (after assets are replaced on disk)
+JNIEXPORT void JNICALL native_invalidate_assets(JNIEnv *env, jobject thiz) {
+    pthread_mutex_lock(&g_lock);
+    cache_clear_locked();
+    pthread_mutex_unlock(&g_lock);
+
+    // Cached responses may point at replaced files or come from replaced code
+    bridge_cache_forget(NULL, 0);
+    LOGI("🗂️ Asset path cache cleared");
+}
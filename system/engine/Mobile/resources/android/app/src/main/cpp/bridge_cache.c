@@ -0,0 +1,594 @@
+#include <android/log.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include "PHP.h"
+
+#define LOG_TAG "PHP-Cache"
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+// Response cache
+// A route marked with Router ->cache(ttl, vary, tags) sends
+// "X-Bridge-Cache: ttl=N; vary=cookie:PHPSESSID,header:Accept; tags=a,b".
+// The bridge takes that header out of the head and, once the request is done,
+// keeps the finished response (status, headers, body or X-Sendfile path) in
+// an LRU bounded by MVC_RESPONSE_CACHE_MB (8 by default, 0 = off). A later GET
+// for the same URI and vary values is answered from here before the Zend
+// engine is entered. Entries expire after their ttl or when PHP forgets one of
+// their tags (nativephp_cache_forget()).
+//
+// Which values a URI varies on is only known from its response, so the vary
+// list is remembered per URI and the full key is built from it on lookup. A
+// vary row lives as long as the entries stored under it: an entry without its
+// row could never be found again. When a URI's vary list changes, the entries
+// keyed on the old one are dropped with it.
+
+#define CACHE_HEADER "X-Bridge-Cache"
+#define CACHE_DEFAULT_MB 8
+#define CACHE_BUCKETS 256
+#define CACHE_MAX_ENTRIES 512
+#define CACHE_KEY_MAX 2048
+#define VARY_BUCKETS 128
+#define VARY_MAX_ENTRIES 1024
+
+typedef struct cache_entry {
+    struct cache_entry *next;           // bucket chain
+    struct cache_entry *newer;          // LRU list, newest first
+    struct cache_entry *older;
+    uint32_t hash;
+    int status;
+    char *headers;                      // "name\0value\0" pairs
+    size_t header_length;
+    size_t header_count;
+    char *body;
+    size_t body_length;
+    char *file;                         // X-Sendfile path instead of a body
+    off_t file_size;                    // the file as it was when stored
+    int64_t file_mtime_ns;
+    char *tags;                         // ",a,b,"
+    struct vary_entry *vary_row;        // row of the entry's URI
+    uint64_t stored_ns;
+    uint64_t expires_ns;
+    size_t bytes;
+    char key[];
+} cache_entry;
+
+typedef struct vary_entry {
+    struct vary_entry *next;
+    uint32_t hash;
+    size_t entries;                     // cache entries stored under this row
+    char *vary;                         // "cookie:PHPSESSID,header:Accept"
+    char uri[];
+} vary_entry;
+
+static cache_entry *g_buckets[CACHE_BUCKETS];
+static cache_entry *g_newest = NULL;
+static cache_entry *g_oldest = NULL;
+static size_t g_entry_count = 0;
+static size_t g_bytes = 0;
+static size_t g_capacity = 0;
+
+static vary_entry *g_vary[VARY_BUCKETS];
+static size_t g_vary_count = 0;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hash_key(const char *key) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *) key; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+static void vary_unlink_locked(vary_entry *v) {
+    vary_entry **slot = &g_vary[v->hash % VARY_BUCKETS];
+    while (*slot && *slot != v) slot = &(*slot)->next;
+    if (*slot) *slot = v->next;
+
+    g_vary_count--;
+    free(v->vary);
+    free(v);
+}
+
+static void entry_free(cache_entry *e) {
+    free(e->headers);
+    free(e->body);
+    free(e->file);
+    free(e->tags);
+    free(e);
+}
+
+static void entry_unlink_locked(cache_entry *e) {
+    cache_entry **slot = &g_buckets[e->hash % CACHE_BUCKETS];
+    while (*slot && *slot != e) slot = &(*slot)->next;
+    if (*slot) *slot = e->next;
+
+    if (e->newer) e->newer->older = e->older; else g_newest = e->older;
+    if (e->older) e->older->newer = e->newer; else g_oldest = e->newer;
+
+    g_entry_count--;
+    g_bytes -= e->bytes;
+    if (e->vary_row && --e->vary_row->entries == 0) {
+        vary_unlink_locked(e->vary_row);
+    }
+    entry_free(e);
+}
+
+static void vary_clear_locked(void) {
+    for (size_t i = 0; i < VARY_BUCKETS; i++) {
+        vary_entry *v = g_vary[i];
+        while (v) {
+            vary_entry *next = v->next;
+            free(v->vary);
+            free(v);
+            v = next;
+        }
+        g_vary[i] = NULL;
+    }
+    g_vary_count = 0;
+}
+
+static void cache_clear_locked(void) {
+    while (g_oldest) entry_unlink_locked(g_oldest);
+    vary_clear_locked();
+}
+
+static cache_entry *entry_find_locked(const char *key, uint32_t hash) {
+    for (cache_entry *e = g_buckets[hash % CACHE_BUCKETS]; e; e = e->next) {
+        if (e->hash == hash && strcmp(e->key, key) == 0) return e;
+    }
+    return NULL;
+}
+
+static vary_entry *vary_find_locked(const char *uri, uint32_t hash) {
+    for (vary_entry *v = g_vary[hash % VARY_BUCKETS]; v; v = v->next) {
+        if (v->hash == hash && strcmp(v->uri, uri) == 0) return v;
+    }
+    return NULL;
+}
+
+// Row for uri with the given vary list, created when missing; NULL when out of memory
+static vary_entry *vary_store_locked(const char *uri, const char *vary) {
+    uint32_t hash = hash_key(uri);
+    vary_entry *v = vary_find_locked(uri, hash);
+    if (!v) {
+        // Rows only outlive their entries by accident; evicting the oldest
+        // entries drops their rows with them
+        while (g_vary_count >= VARY_MAX_ENTRIES && g_oldest) entry_unlink_locked(g_oldest);
+
+        size_t length = strlen(uri);
+        v = calloc(1, sizeof(vary_entry) + length + 1);
+        if (!v) return NULL;
+        v->hash = hash;
+        memcpy(v->uri, uri, length + 1);
+        v->next = g_vary[hash % VARY_BUCKETS];
+        g_vary[hash % VARY_BUCKETS] = v;
+        g_vary_count++;
+    } else if (v->vary && strcmp(v->vary, vary) == 0) {
+        return v;
+    } else {
+        // Entries keyed on the old vary list can never be found again; the
+        // extra count keeps the row alive while they go
+        v->entries++;
+        for (cache_entry *e = g_oldest; e;) {
+            cache_entry *newer = e->newer;
+            if (e->vary_row == v) entry_unlink_locked(e);
+            e = newer;
+        }
+        v->entries--;
+    }
+    free(v->vary);
+    v->vary = strdup(vary);
+    return v;
+}
+
+// Called from the nativephp extension's MINIT
+void bridge_cache_startup(void) {
+    const char *mb = getenv("MVC_RESPONSE_CACHE_MB");
+    size_t size = mb && *mb ? (size_t) strtoul(mb, NULL, 10) : CACHE_DEFAULT_MB;
+
+    pthread_mutex_lock(&g_lock);
+    g_capacity = size * 1024 * 1024;
+    pthread_mutex_unlock(&g_lock);
+
+    if (g_capacity) LOGI("🗄️ Response cache enabled (%zuMB)", size);
+}
+
+void bridge_cache_shutdown(void) {
+    pthread_mutex_lock(&g_lock);
+    cache_clear_locked();
+    g_capacity = 0;
+    pthread_mutex_unlock(&g_lock);
+}
+
+void bridge_cache_directive_reset(void) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    free(ctx->cache_directive);
+    ctx->cache_directive = NULL;
+}
+
+/**
+ * Consume an X-Bridge-Cache response header. Returns 1 when name is that
+ * header (it must not reach the WebView), 0 for any other header.
+ */
+int bridge_cache_header(const char *name, size_t name_length, const char *value, size_t value_length) {
+    if (name_length != sizeof(CACHE_HEADER) - 1 || strncasecmp(name, CACHE_HEADER, name_length) != 0) {
+        return 0;
+    }
+
+    bridge_cache_directive_reset();
+    if (g_capacity) {
+        bridge_ctx()->cache_directive = strndup(value, value_length);
+    }
+    return 1;
+}
+
+// Copy the "name=" field of a "a=1; b=2" directive into out
+static void directive_field(const char *directive, const char *name, char *out, size_t size) {
+    size_t name_length = strlen(name);
+    out[0] = '\0';
+
+    for (const char *p = directive; p && *p;) {
+        while (*p == ' ' || *p == ';') p++;
+        const char *end = strchr(p, ';');
+        size_t length = end ? (size_t) (end - p) : strlen(p);
+
+        if (length > name_length && strncmp(p, name, name_length) == 0 && p[name_length] == '=') {
+            size_t value_length = length - name_length - 1;
+            if (value_length >= size) value_length = size - 1;
+            memcpy(out, p + name_length + 1, value_length);
+            out[value_length] = '\0';
+            while (value_length > 0 && out[value_length - 1] == ' ') out[--value_length] = '\0';
+            return;
+        }
+        p = end;
+    }
+}
+
+static const char *request_header(const bridge_request *req, const char *name, size_t name_length) {
+    for (size_t i = 0; i < req->header_count; i++) {
+        if (strlen(req->header_names[i]) == name_length &&
+            strncasecmp(req->header_names[i], name, name_length) == 0) {
+            return req->header_values[i];
+        }
+    }
+    return NULL;
+}
+
+// Copy the value of cookie name (from the Cookie header) into out
+static size_t cookie_value(const bridge_request *req, const char *name, size_t name_length, char *out, size_t size) {
+    for (const char *p = req->cookie; p && *p;) {
+        while (*p == ' ' || *p == ';') p++;
+        const char *end = strchr(p, ';');
+        size_t length = end ? (size_t) (end - p) : strlen(p);
+
+        if (length > name_length && strncmp(p, name, name_length) == 0 && p[name_length] == '=') {
+            size_t value_length = length - name_length - 1;
+            if (value_length >= size) value_length = size - 1;
+            memcpy(out, p + name_length + 1, value_length);
+            out[value_length] = '\0';
+            return value_length;
+        }
+        p = end;
+    }
+    out[0] = '\0';
+    return 0;
+}
+
+// "uri\nvary1=value1\nvary2=value2" into key; 0 when it does not fit
+static int build_key(const bridge_request *req, const char *vary, char *key, size_t size) {
+    int n = snprintf(key, size, "%s", req->uri);
+    if (n < 0 || (size_t) n >= size) return 0;
+    size_t length = (size_t) n;
+
+    for (const char *p = vary; p && *p;) {
+        const char *end = strchr(p, ',');
+        size_t token_length = end ? (size_t) (end - p) : strlen(p);
+        char value[512] = "";
+
+        if (token_length > 7 && strncmp(p, "cookie:", 7) == 0) {
+            char name[128];
+            size_t name_length = token_length - 7 < sizeof(name) ? token_length - 7 : sizeof(name) - 1;
+            memcpy(name, p + 7, name_length);
+            name[name_length] = '\0';
+            cookie_value(req, name, name_length, value, sizeof(value));
+        } else if (token_length > 7 && strncmp(p, "header:", 7) == 0) {
+            const char *header = request_header(req, p + 7, token_length - 7);
+            if (header) snprintf(value, sizeof(value), "%s", header);
+        }
+
+        n = snprintf(key + length, size - length, "\n%.*s=%s", (int) token_length, p, value);
+        if (n < 0 || (size_t) n >= size - length) return 0;
+        length += (size_t) n;
+        p = end ? end + 1 : NULL;
+    }
+    return 1;
+}
+
+// Value of header name among "name\0value\0" pairs, or NULL
+static const char *pairs_find(const char *pairs, size_t count, const char *wanted) {
+    const char *p = pairs;
+    for (size_t i = 0; i < count; i++) {
+        const char *name = p;
+        const char *value = name + strlen(name) + 1;
+        p = value + strlen(value) + 1;
+        if (strcasecmp(name, wanted) == 0) return value;
+    }
+    return NULL;
+}
+
+/**
+ * Keep the response just produced for req if its route asked for it
+ * (X-Bridge-Cache) and it is cacheable: a GET answered 200 without
+ * Set-Cookie. body is the full output (buffered, or the copy kept while
+ * streaming); file the X-Sendfile path, if any.
+ */
+void bridge_cache_store(const bridge_request *req, const char *body, size_t body_length, const char *file) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    const char *directive = ctx->cache_directive;
+    if (!directive || !g_capacity) return;
+
+    char field[512];
+    directive_field(directive, "ttl", field, sizeof(field));
+    uint64_t ttl = strtoull(field, NULL, 10);
+
+    if (ttl == 0 || strcmp(req->method, "GET") != 0 || ctx->status_code != 200 ||
+        pairs_find(ctx->headers, ctx->header_count, "Set-Cookie")) {
+        bridge_cache_directive_reset();
+        return;
+    }
+
+    char vary[512];
+    char tags[512];
+    char key[CACHE_KEY_MAX];
+    directive_field(directive, "vary", vary, sizeof(vary));
+    directive_field(directive, "tags", field, sizeof(field));
+    snprintf(tags, sizeof(tags), ",%s,", field);
+    bridge_cache_directive_reset();
+
+    if (!build_key(req, vary, key, sizeof(key))) return;
+
+    // Copy the head without the per-request Server-Timing
+    size_t key_length = strlen(key);
+    char *headers = malloc(ctx->header_length ? ctx->header_length : 1);
+    size_t header_length = 0;
+    size_t header_count = 0;
+    if (!headers) return;
+
+    const char *p = ctx->headers;
+    for (size_t i = 0; i < ctx->header_count; i++) {
+        const char *name = p;
+        const char *value = name + strlen(name) + 1;
+        p = value + strlen(value) + 1;
+        if (strcasecmp(name, "Server-Timing") == 0) continue;
+        memcpy(headers + header_length, name, (size_t) (p - name));
+        header_length += (size_t) (p - name);
+        header_count++;
+    }
+
+    // The cached head describes the file as it is now (Content-Length, ETag)
+    struct stat st;
+    if (file) {
+        if (stat(file, &st) != 0) {
+            free(headers);
+            return;
+        }
+        body_length = 0;
+    }
+    size_t bytes = sizeof(cache_entry) + key_length + header_length + body_length + (file ? strlen(file) : 0);
+    if (bytes > g_capacity / 4) {
+        free(headers);
+        return;
+    }
+
+    cache_entry *e = calloc(1, sizeof(cache_entry) + key_length + 1);
+    char *copy = body_length ? malloc(body_length) : NULL;
+    if (!e || (body_length && !copy)) {
+        free(e);
+        free(copy);
+        free(headers);
+        return;
+    }
+    memcpy(e->key, key, key_length + 1);
+    if (copy) memcpy(copy, body, body_length);
+
+    e->hash = hash_key(key);
+    e->status = ctx->status_code;
+    e->headers = headers;
+    e->header_length = header_length;
+    e->header_count = header_count;
+    e->body = copy;
+    e->body_length = body_length;
+    e->file = file ? strdup(file) : NULL;
+    if (file) {
+        e->file_size = st.st_size;
+        e->file_mtime_ns = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    }
+    e->tags = strdup(tags);
+    e->stored_ns = bridge_now_ns();
+    e->expires_ns = e->stored_ns + ttl * 1000000000ull;
+    e->bytes = bytes;
+
+    pthread_mutex_lock(&g_lock);
+    cache_entry *old = entry_find_locked(key, e->hash);
+    if (old) entry_unlink_locked(old);
+    while (g_oldest && (g_bytes + bytes > g_capacity || g_entry_count >= CACHE_MAX_ENTRIES)) {
+        entry_unlink_locked(g_oldest);
+    }
+
+    e->vary_row = vary_store_locked(req->uri, vary);
+    if (!e->vary_row || !e->vary_row->vary) {
+        if (e->vary_row && e->vary_row->entries == 0) vary_unlink_locked(e->vary_row);
+        pthread_mutex_unlock(&g_lock);
+        entry_free(e);
+        return;
+    }
+    e->vary_row->entries++;
+
+    e->next = g_buckets[e->hash % CACHE_BUCKETS];
+    g_buckets[e->hash % CACHE_BUCKETS] = e;
+    e->older = g_newest;
+    if (g_newest) g_newest->newer = e; else g_oldest = e;
+    g_newest = e;
+    g_entry_count++;
+    g_bytes += bytes;
+    pthread_mutex_unlock(&g_lock);
+
+    LOGI("🗄️ Cached %s for %llus (%zu bytes)", req->uri, (unsigned long long) ttl, bytes);
+}
+
+// If-None-Match weakly compared against etag (RFC 9110 13.1.2), as in
+// Response::isNotModified(): a list of tags or "*"
+static int etag_matches(const char *etag, const char *if_none_match) {
+    const char *own = strncmp(etag, "W/", 2) == 0 ? etag + 2 : etag;
+    size_t own_length = strlen(own);
+
+    for (const char *p = if_none_match; p && *p;) {
+        const char *end = strchr(p, ',');
+        size_t length = end ? (size_t) (end - p) : strlen(p);
+        while (length > 0 && (*p == ' ' || *p == '\t')) { p++; length--; }
+        while (length > 0 && (p[length - 1] == ' ' || p[length - 1] == '\t')) length--;
+
+        if (length == 1 && *p == '*') return 1;
+        if (length >= 2 && strncmp(p, "W/", 2) == 0) { p += 2; length -= 2; }
+        if (length == own_length && strncmp(p, own, length) == 0) return 1;
+        p = end ? end + 1 : NULL;
+    }
+    return 0;
+}
+
+/**
+ * Look req up. On a hit returns a copy of the response (one malloc, the
+ * caller frees it); a matching If-None-Match turns it into an empty 304
+ * without Content-Length. NULL on a miss, and for Range or If-Modified-Since
+ * requests, which PHP answers (Response::stream(), isNotModified()).
+ */
+bridge_cached_response *bridge_cache_fetch(const bridge_request *req) {
+    if (!g_capacity || !req->method || strcmp(req->method, "GET") != 0) return NULL;
+
+    const char *if_none_match = request_header(req, "If-None-Match", sizeof("If-None-Match") - 1);
+    if (request_header(req, "Range", sizeof("Range") - 1) ||
+        (!if_none_match && request_header(req, "If-Modified-Since", sizeof("If-Modified-Since") - 1))) {
+        return NULL;
+    }
+
+    char key[CACHE_KEY_MAX];
+    uint64_t now = bridge_now_ns();
+    bridge_cached_response *hit = NULL;
+
+    pthread_mutex_lock(&g_lock);
+    vary_entry *v = vary_find_locked(req->uri, hash_key(req->uri));
+    cache_entry *e = NULL;
+    if (v && build_key(req, v->vary, key, sizeof(key))) {
+        e = entry_find_locked(key, hash_key(key));
+    }
+    if (e && e->expires_ns <= now) {
+        entry_unlink_locked(e);
+        e = NULL;
+    }
+
+    if (e) {
+        // Most recently used to the front
+        if (e != g_newest) {
+            if (e->newer) e->newer->older = e->older;
+            if (e->older) e->older->newer = e->newer; else g_oldest = e->newer;
+            e->newer = NULL;
+            e->older = g_newest;
+            g_newest->newer = e;
+            g_newest = e;
+        }
+
+        const char *etag = pairs_find(e->headers, e->header_count, "ETag");
+        int not_modified = etag && if_none_match && etag_matches(etag, if_none_match);
+
+        size_t body_length = not_modified ? 0 : e->body_length;
+        size_t file_length = (!not_modified && e->file) ? strlen(e->file) + 1 : 0;
+        hit = malloc(sizeof(bridge_cached_response) + e->header_length + body_length + file_length);
+        if (hit) {
+            char *p = (char *) (hit + 1);
+            hit->status = not_modified ? 304 : e->status;
+            hit->age_s = (now - e->stored_ns) / 1000000000ull;
+            hit->header_count = 0;
+            hit->headers = p;
+
+            // A 304 carries no body, so none of its length headers either
+            const char *h = e->headers;
+            for (size_t i = 0; i < e->header_count; i++) {
+                const char *name = h;
+                const char *value = name + strlen(name) + 1;
+                h = value + strlen(value) + 1;
+                if (not_modified && (strcasecmp(name, "Content-Length") == 0 || strcasecmp(name, "Content-Range") == 0)) {
+                    continue;
+                }
+                memcpy(p, name, (size_t) (h - name));
+                p += h - name;
+                hit->header_count++;
+            }
+            hit->body = p;
+            hit->body_length = body_length;
+            if (body_length) memcpy(p, e->body, body_length);
+            p += body_length;
+            hit->file = file_length ? memcpy(p, e->file, file_length) : NULL;
+            hit->file_size = e->file_size;
+            hit->file_mtime_ns = e->file_mtime_ns;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (hit) LOGI("🗄️ Cache hit %s (%d, age %llus)", req->uri, hit->status, (unsigned long long) hit->age_s);
+    return hit;
+}
+
+/**
+ * Drop the entry bridge_cache_fetch() would return for req, e.g. a hit whose
+ * X-Sendfile file is gone or changed.
+ */
+void bridge_cache_evict(const bridge_request *req) {
+    char key[CACHE_KEY_MAX];
+
+    pthread_mutex_lock(&g_lock);
+    vary_entry *v = vary_find_locked(req->uri, hash_key(req->uri));
+    if (v && build_key(req, v->vary, key, sizeof(key))) {
+        cache_entry *e = entry_find_locked(key, hash_key(key));
+        if (e) entry_unlink_locked(e);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+/**
+ * Drop every entry carrying one of tags (count of them), or all entries when
+ * tags is NULL. Returns the number of entries removed.
+ */
+size_t bridge_cache_forget(const char *const *tags, size_t count) {
+    size_t removed = 0;
+
+    pthread_mutex_lock(&g_lock);
+    if (!tags) {
+        removed = g_entry_count;
+        cache_clear_locked();
+    } else {
+        cache_entry *e = g_oldest;
+        while (e) {
+            cache_entry *newer = e->newer;
+            for (size_t i = 0; i < count; i++) {
+                char needle[256];
+                snprintf(needle, sizeof(needle), ",%s,", tags[i]);
+                if (strstr(e->tags, needle)) {
+                    entry_unlink_locked(e);
+                    removed++;
+                    break;
+                }
+            }
+            e = newer;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (removed) LOGI("🗄️ Forgot %zu cached responses", removed);
+    return removed;
+}
@@ -1,87 +1,154 @@
 #include <jni.h>
 #include <android/log.h>
+#include <pthread.h>
 #include <string>
+#include <cstring>
 
 #define LOG_TAG "BridgeJNI"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
+// Hot-path logging (per call, payloads) is compiled out unless
+// BRIDGE_JNI_LOG_LEVEL is at or below 3 (ANDROID_LOG_DEBUG). Debug builds
+// default to 3, release builds to 5 (ANDROID_LOG_WARN).
+#ifndef BRIDGE_JNI_LOG_LEVEL
+#ifdef DEBUG
+#define BRIDGE_JNI_LOG_LEVEL 3
+#else
+#define BRIDGE_JNI_LOG_LEVEL 5
+#endif
+#endif
+
+#if BRIDGE_JNI_LOG_LEVEL <= 3
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGD(...) ((void) 0)
+#endif
+
 // Use the shared JavaVM from php_bridge.c
 extern "C" JavaVM* g_jvm;
 
-static jclass g_bridgeRouterClass = nullptr;
-static jmethodID g_nativePHPCanMethod = nullptr;
-static jmethodID g_nativePHPCallMethod = nullptr;
+// BridgeRouterKt and its entry points, resolved once in InitializeBridgeJNI
+static struct {
+    jclass routerClass;
+    jmethodID can;
+    jmethodID call;
+    jmethodID callMap;
+    jmethodID callMany;
+    jmethodID callAsync;
+    jmethodID await;
+    jmethodID result;
+    bool ready;
+} g_bridge = {};
+
+// Receives a result while the Java string is still pinned, so the caller can
+// copy it into memory it owns (see NativePHPResultSink in PHP.h)
+typedef void (*NativePHPResultSink)(void* target, const char* data, size_t length);
 
 // Initialization function to be called from php_bridge.c's JNI_OnLoad
 extern "C" jint InitializeBridgeJNI(JNIEnv* env) {
     LOGI("🔌 BridgeJNI: InitializeBridgeJNI called");
 
-    // Find the BridgeRouter class and cache method IDs
-    LOGI("🔍 BridgeJNI: Looking for com/fuse/php/bridge/BridgeRouterKt class...");
     jclass localClass = env->FindClass("com/fuse/php/bridge/BridgeRouterKt");
     if (localClass == nullptr) {
         LOGE("❌ BridgeJNI: Failed to find BridgeRouterKt class");
         return JNI_ERR;
     }
-    LOGI("✅ BridgeJNI: Found BridgeRouterKt class");
 
-    // Create global reference
-    g_bridgeRouterClass = reinterpret_cast<jclass>(env->NewGlobalRef(localClass));
+    g_bridge.routerClass = reinterpret_cast<jclass>(env->NewGlobalRef(localClass));
     env->DeleteLocalRef(localClass);
 
-    if (g_bridgeRouterClass == nullptr) {
+    if (g_bridge.routerClass == nullptr) {
         LOGE("BridgeJNI: Failed to create global reference to BridgeRouterKt");
         return JNI_ERR;
     }
 
-    // Get method IDs
-    g_nativePHPCanMethod = env->GetStaticMethodID(g_bridgeRouterClass, "nativePHPCan",
-                                                    "(Ljava/lang/String;)I");
-    if (g_nativePHPCanMethod == nullptr) {
-        LOGE("BridgeJNI: Failed to find nativePHPCan method");
-        return JNI_ERR;
+    const struct {
+        jmethodID* slot;
+        const char* name;
+        const char* signature;
+    } methods[] = {
+        {&g_bridge.can,       "nativePHPCan",       "(Ljava/lang/String;)I"},
+        {&g_bridge.call,      "nativePHPCall",      "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"},
+        {&g_bridge.callMap,   "nativePHPCallMap",   "(Ljava/lang/String;Ljava/util/Map;)Ljava/util/Map;"},
+        {&g_bridge.callMany,  "nativePHPCallMany",  "(Ljava/util/List;)Ljava/util/List;"},
+        {&g_bridge.callAsync, "nativePHPCallAsync", "(Ljava/lang/String;Ljava/util/Map;)J"},
+        {&g_bridge.await,     "nativePHPAwait",     "([JJ)J"},
+        {&g_bridge.result,    "nativePHPResult",    "(J)Ljava/util/Map;"},
+    };
+
+    for (const auto& method : methods) {
+        *method.slot = env->GetStaticMethodID(g_bridge.routerClass, method.name, method.signature);
+        if (*method.slot == nullptr) {
+            env->ExceptionClear();
+            LOGE("❌ BridgeJNI: Failed to find %s method", method.name);
+            return JNI_ERR;
+        }
     }
 
-    g_nativePHPCallMethod = env->GetStaticMethodID(g_bridgeRouterClass, "nativePHPCall",
-                                                     "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;");
-    if (g_nativePHPCallMethod == nullptr) {
-        LOGE("BridgeJNI: Failed to find nativePHPCall method");
-        return JNI_ERR;
+    g_bridge.ready = true;
+    LOGI("✅ BridgeJNI: Initialization successful");
+    return JNI_OK;
+}
+
+// Per-thread JNIEnv; valid for the thread's lifetime once looked up
+static thread_local JNIEnv* t_env = nullptr;
+
+static pthread_key_t g_detachKey;
+static pthread_once_t g_detachKeyOnce = PTHREAD_ONCE_INIT;
+
+// Runs at exit of threads we attached ourselves, so they don't stay
+// registered with the VM forever
+static void DetachOnThreadExit(void*) {
+    if (g_jvm != nullptr) {
+        g_jvm->DetachCurrentThread();
     }
+}
 
-    LOGI("BridgeJNI: Initialization successful");
-    return JNI_OK;
+static void CreateDetachKey() {
+    pthread_key_create(&g_detachKey, DetachOnThreadExit);
 }
 
 // Helper to get JNIEnv for current thread
 static JNIEnv* GetJNIEnv() {
-    JNIEnv* env = nullptr;
+    if (t_env != nullptr) {
+        return t_env;
+    }
 
-    if (g_jvm == nullptr) {
-        LOGE("BridgeJNI: JVM is null");
+    if (g_jvm == nullptr || !g_bridge.ready) {
+        LOGE("BridgeJNI: Bridge not initialized");
         return nullptr;
     }
 
+    JNIEnv* env = nullptr;
     jint result = g_jvm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
 
     if (result == JNI_EDETACHED) {
-        // Thread not attached, attach it
-        result = g_jvm->AttachCurrentThread(&env, nullptr);
+        // Native thread: attach as a daemon so it never holds up VM shutdown,
+        // and detach automatically when the thread exits
+        result = g_jvm->AttachCurrentThreadAsDaemon(&env, nullptr);
         if (result != JNI_OK) {
             LOGE("BridgeJNI: Failed to attach current thread");
             return nullptr;
         }
+        pthread_once(&g_detachKeyOnce, CreateDetachKey);
+        pthread_setspecific(g_detachKey, env);
+        LOGD("BridgeJNI: Attached native thread %lu", static_cast<unsigned long>(pthread_self()));
     } else if (result != JNI_OK) {
         LOGE("BridgeJNI: Failed to get JNIEnv");
         return nullptr;
     }
 
+    t_env = env;
     return env;
 }
 
 // C functions that PHP can call
 
+extern "C" JNIEnv* NativeBridgeEnv() {
+    return GetJNIEnv();
+}
+
 /**
  * Check if a native function exists in the bridge registry
  * Called from PHP
@@ -106,47 +173,159 @@ extern "C" int NativePHPCan(const char* functionName) {
         return 0;
     }
 
-    jint result = env->CallStaticIntMethod(g_bridgeRouterClass, g_nativePHPCanMethod, jFunctionName);
+    jint result = env->CallStaticIntMethod(g_bridge.routerClass, g_bridge.can, jFunctionName);
 
     env->DeleteLocalRef(jFunctionName);
 
-    LOGI("BridgeJNI: NativePHPCan('%s') = %d", functionName, result);
+    LOGD("BridgeJNI: NativePHPCan('%s') = %d", functionName, result);
     return static_cast<int>(result);
 }
 
+/**
+ * Call a native function through the bridge router with already-marshalled parameters
+ * Called from the nativephp extension
+ * @param env JNIEnv of the calling interpreter thread
+ * @param functionName The fully qualified function name (e.g., "Location.Get")
+ * @param parameters java.util.Map of parameters
+ * @return Local reference to the result Map, or NULL if function doesn't exist
+ */
+extern "C" jobject NativePHPCallMap(JNIEnv* env, const char* functionName, jobject parameters) {
+    if (functionName == nullptr) {
+        LOGE("❌ BridgeJNI: NativePHPCallMap called with null function name");
+        return nullptr;
+    }
+
+    jstring jFunctionName = env->NewStringUTF(functionName);
+    if (jFunctionName == nullptr) {
+        LOGE("❌ BridgeJNI: Failed to create jstring for function name");
+        return nullptr;
+    }
+
+    jobject jResult = env->CallStaticObjectMethod(g_bridge.routerClass, g_bridge.callMap,
+                                                    jFunctionName, parameters);
+    env->DeleteLocalRef(jFunctionName);
+
+    if (env->ExceptionCheck()) {
+        LOGE("❌ BridgeJNI: NativePHPCallMap('%s') threw", functionName);
+        env->ExceptionClear();
+        return nullptr;
+    }
+
+    return jResult;
+}
+
+/**
+ * Call several native functions in one JNI transition
+ * Called from the nativephp extension
+ * @param env JNIEnv of the calling interpreter thread
+ * @param calls java.util.List of {name, params} maps
+ * @return Local reference to the List of results, or NULL on failure
+ */
+extern "C" jobject NativePHPCallMany(JNIEnv* env, jobject calls) {
+    jobject jResult = env->CallStaticObjectMethod(g_bridge.routerClass, g_bridge.callMany, calls);
+
+    if (env->ExceptionCheck()) {
+        LOGE("❌ BridgeJNI: NativePHPCallMany threw");
+        env->ExceptionClear();
+        return nullptr;
+    }
+
+    return jResult;
+}
+
+/**
+ * Start a native function on the bridge executor without waiting for it
+ * Called from the nativephp extension
+ * @return Ticket for NativePHPAwait/NativePHPResult, or 0 if function doesn't exist
+ */
+extern "C" jlong NativePHPCallAsync(JNIEnv* env, const char* functionName, jobject parameters) {
+    jstring jFunctionName = env->NewStringUTF(functionName);
+    if (jFunctionName == nullptr) {
+        LOGE("❌ BridgeJNI: Failed to create jstring for function name");
+        return 0;
+    }
+
+    jlong ticket = env->CallStaticLongMethod(g_bridge.routerClass, g_bridge.callAsync,
+                                             jFunctionName, parameters);
+    env->DeleteLocalRef(jFunctionName);
+
+    if (env->ExceptionCheck()) {
+        LOGE("❌ BridgeJNI: NativePHPCallAsync('%s') threw", functionName);
+        env->ExceptionClear();
+        return 0;
+    }
+    return ticket;
+}
+
+/**
+ * Block until one of the given async calls has finished
+ * @param timeoutMs Negative waits forever
+ * @return The finished ticket, or 0 on timeout
+ */
+extern "C" jlong NativePHPAwait(JNIEnv* env, const jlong* tickets, size_t count, jlong timeoutMs) {
+    jlongArray jTickets = env->NewLongArray(static_cast<jsize>(count));
+    if (jTickets == nullptr) {
+        env->ExceptionClear();
+        return 0;
+    }
+    env->SetLongArrayRegion(jTickets, 0, static_cast<jsize>(count), tickets);
+
+    jlong ticket = env->CallStaticLongMethod(g_bridge.routerClass, g_bridge.await, jTickets, timeoutMs);
+    env->DeleteLocalRef(jTickets);
+
+    if (env->ExceptionCheck()) {
+        LOGE("❌ BridgeJNI: NativePHPAwait threw");
+        env->ExceptionClear();
+        return 0;
+    }
+    return ticket;
+}
+
+/**
+ * Collect the result of a finished async call
+ * @return Local reference to the result Map, or NULL if unknown or still running
+ */
+extern "C" jobject NativePHPResult(JNIEnv* env, jlong ticket) {
+    jobject jResult = env->CallStaticObjectMethod(g_bridge.routerClass, g_bridge.result, ticket);
+
+    if (env->ExceptionCheck()) {
+        LOGE("❌ BridgeJNI: NativePHPResult threw");
+        env->ExceptionClear();
+        return nullptr;
+    }
+    return jResult;
+}
+
 /**
  * Call a native function through the bridge router
  * Called from PHP
  * @param functionName The fully qualified function name (e.g., "Location.Get")
  * @param parametersJSON JSON string containing function parameters
- * @return JSON string with result or NULL if function doesn't exist
+ * @param sink Receives the result JSON; not called if function doesn't exist
+ * @param target Passed through to sink
+ * @return 1 if a result was delivered, 0 otherwise
  */
-extern "C" const char* NativePHPCall(const char* functionName, const char* parametersJSON) {
-    LOGI("🚀 BridgeJNI: NativePHPCall called with function='%s'", functionName ? functionName : "NULL");
-    if (parametersJSON) {
-        LOGI("📦 BridgeJNI: Parameters JSON: %s", parametersJSON);
-    } else {
-        LOGI("📦 BridgeJNI: Parameters JSON: NULL");
-    }
+extern "C" int NativePHPCall(const char* functionName, const char* parametersJSON,
+                             NativePHPResultSink sink, void* target) {
+    LOGD("🚀 BridgeJNI: NativePHPCall('%s') params: %s", functionName ? functionName : "NULL",
+         parametersJSON ? parametersJSON : "NULL");
 
     if (functionName == nullptr) {
         LOGE("❌ BridgeJNI: NativePHPCall called with null function name");
-        return nullptr;
+        return 0;
     }
 
     JNIEnv* env = GetJNIEnv();
     if (env == nullptr) {
         LOGE("❌ BridgeJNI: Failed to get JNIEnv in NativePHPCall");
-        return nullptr;
+        return 0;
     }
-    LOGI("✅ BridgeJNI: Got JNIEnv successfully");
 
     jstring jFunctionName = env->NewStringUTF(functionName);
     if (jFunctionName == nullptr) {
         LOGE("❌ BridgeJNI: Failed to create jstring for function name");
-        return nullptr;
+        return 0;
     }
-    LOGI("✅ BridgeJNI: Created jstring for function name");
 
     jstring jParametersJSON = nullptr;
     if (parametersJSON != nullptr) {
@@ -154,13 +333,11 @@ extern "C" const char* NativePHPCall(const char* functionName, const char* param
         if (jParametersJSON == nullptr) {
             LOGE("❌ BridgeJNI: Failed to create jstring for parameters");
             env->DeleteLocalRef(jFunctionName);
-            return nullptr;
+            return 0;
         }
-        LOGI("✅ BridgeJNI: Created jstring for parameters");
     }
 
-    LOGI("🔄 BridgeJNI: Calling Kotlin nativePHPCall method...");
-    jobject jResult = env->CallStaticObjectMethod(g_bridgeRouterClass, g_nativePHPCallMethod,
+    jobject jResult = env->CallStaticObjectMethod(g_bridge.routerClass, g_bridge.call,
                                                     jFunctionName, jParametersJSON);
 
     env->DeleteLocalRef(jFunctionName);
@@ -169,28 +346,25 @@ extern "C" const char* NativePHPCall(const char* functionName, const char* param
     }
 
     if (jResult == nullptr) {
-        LOGI("⚠️ BridgeJNI: NativePHPCall returned null");
-        return nullptr;
+        LOGD("⚠️ BridgeJNI: NativePHPCall returned null");
+        return 0;
     }
-    LOGI("✅ BridgeJNI: Got non-null result from Kotlin");
 
     // Convert Java String to C string
     const char* resultStr = env->GetStringUTFChars(static_cast<jstring>(jResult), nullptr);
     if (resultStr == nullptr) {
         LOGE("❌ BridgeJNI: Failed to get C string from result");
         env->DeleteLocalRef(jResult);
-        return nullptr;
+        return 0;
     }
 
-    LOGI("📤 BridgeJNI: Result JSON: %s", resultStr);
+    LOGD("📤 BridgeJNI: Result JSON: %s", resultStr);
 
-    // We need to make a copy because we're releasing the Java string
-    // Note: This memory will be managed by PHP
-    char* resultCopy = strdup(resultStr);
+    // Copy out while the chars are pinned; the caller owns the copy
+    sink(target, resultStr, strlen(resultStr));
 
     env->ReleaseStringUTFChars(static_cast<jstring>(jResult), resultStr);
     env->DeleteLocalRef(jResult);
 
-    LOGI("✅ BridgeJNI: NativePHPCall('%s') completed successfully", functionName);
-    return resultCopy;
-}
\ No newline at end of file
+    return 1;
+}
@@ -0,0 +1,277 @@
+#include <android/log.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "php_embed.h"
+#include "PHP.h"
+
+#define LOG_TAG "PHP-Metrics"
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
+
+// Request metrics
+// Every request served by the bridge is timed phase by phase in its
+// interpreter's bridge_request_ctx, then copied into a small ring shared by
+// all interpreters. Kotlin reads the ring through PHPBridge.metrics(), PHP
+// through nativephp_metrics(), and each response carries a Server-Timing header.
+
+static bridge_metrics g_ring[BRIDGE_METRICS_RING];
+static size_t g_ring_next = 0;
+static size_t g_ring_count = 0;
+static uint64_t g_next_id = 1;
+static pthread_mutex_t g_ring_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *phase_names[BRIDGE_PHASE_COUNT] = {
+    "startup", "globals", "compile", "execute", "output", "shutdown"
+};
+
+// Compile hooks wrapped while the engine runs; restored at module shutdown so
+// an engine restart does not wrap its own wrapper
+static zend_op_array *(*prev_compile_file)(zend_file_handle *file_handle, int type) = NULL;
+static zend_op_array *(*prev_compile_string)(zend_string *source, const char *filename, zend_compile_position position) = NULL;
+
+uint64_t bridge_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static int64_t wall_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+const char *bridge_phase_name(bridge_phase phase) {
+    return phase < BRIDGE_PHASE_COUNT ? phase_names[phase] : "unknown";
+}
+
+static zend_op_array *metrics_compile_file(zend_file_handle *file_handle, int type) {
+    uint64_t start = bridge_now_ns();
+    zend_op_array *op_array = prev_compile_file(file_handle, type);
+    bridge_metrics_mark(BRIDGE_PHASE_COMPILE, start);
+    return op_array;
+}
+
+static zend_op_array *metrics_compile_string(zend_string *source, const char *filename, zend_compile_position position) {
+    uint64_t start = bridge_now_ns();
+    zend_op_array *op_array = prev_compile_string(source, filename, position);
+    bridge_metrics_mark(BRIDGE_PHASE_COMPILE, start);
+    return op_array;
+}
+
+// Called from the nativephp extension's MINIT
+void bridge_metrics_startup(void) {
+    prev_compile_file = zend_compile_file;
+    zend_compile_file = metrics_compile_file;
+    prev_compile_string = zend_compile_string;
+    zend_compile_string = metrics_compile_string;
+}
+
+void bridge_metrics_shutdown(void) {
+    if (prev_compile_file) {
+        zend_compile_file = prev_compile_file;
+        prev_compile_file = NULL;
+    }
+    if (prev_compile_string) {
+        zend_compile_string = prev_compile_string;
+        prev_compile_string = NULL;
+    }
+}
+
+void bridge_metrics_begin(bridge_request *req, int worker) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    bridge_metrics *m = &ctx->metrics;
+
+    memset(m, 0, sizeof(*m));
+    m->started_at_ms = wall_clock_ms();
+    m->worker = worker;
+    if (req) {
+        snprintf(m->method, sizeof(m->method), "%s", req->method ? req->method : "");
+        snprintf(m->uri, sizeof(m->uri), "%s", req->uri ? req->uri : "");
+    }
+
+    // Per-request peak, also for a worker whose heap lives across requests
+    zend_memory_reset_peak_usage();
+
+    ctx->metrics_start_ns = bridge_now_ns();
+    ctx->execute_start_ns = 0;
+    ctx->execute_excluded_ns = 0;
+}
+
+// Add the time since since_ns to phase; returns now, for chaining marks
+uint64_t bridge_metrics_mark(bridge_phase phase, uint64_t since_ns) {
+    uint64_t now = bridge_now_ns();
+    bridge_ctx()->metrics.phase_ns[phase] += now - since_ns;
+    return now;
+}
+
+void bridge_metrics_output(size_t length, uint64_t since_ns) {
+    bridge_ctx()->metrics.bytes_out += length;
+    bridge_metrics_mark(BRIDGE_PHASE_OUTPUT, since_ns);
+}
+
+void bridge_metrics_execute_begin(void) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    ctx->execute_start_ns = bridge_now_ns();
+    ctx->execute_excluded_ns = ctx->metrics.phase_ns[BRIDGE_PHASE_COMPILE] + ctx->metrics.phase_ns[BRIDGE_PHASE_OUTPUT];
+}
+
+void bridge_metrics_execute_end(void) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!ctx->execute_start_ns) return;
+
+    uint64_t elapsed = bridge_now_ns() - ctx->execute_start_ns;
+    uint64_t excluded = ctx->metrics.phase_ns[BRIDGE_PHASE_COMPILE] + ctx->metrics.phase_ns[BRIDGE_PHASE_OUTPUT]
+                        - ctx->execute_excluded_ns;
+    ctx->metrics.phase_ns[BRIDGE_PHASE_EXECUTE] += elapsed > excluded ? elapsed - excluded : 0;
+    ctx->execute_start_ns = 0;
+}
+
+// Must run before request shutdown, which resets the heap's peak
+void bridge_metrics_capture_memory(void) {
+    bridge_ctx()->metrics.peak_memory = zend_memory_peak_usage(0);
+}
+
+// Finish the request in flight and publish it to the ring
+void bridge_metrics_end(void) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    bridge_metrics *m = &ctx->metrics;
+
+    bridge_metrics_execute_end();
+    m->status = ctx->status_code;
+    m->total_ns = bridge_now_ns() - ctx->metrics_start_ns;
+    m->heap_size = zend_memory_usage(1);
+
+    pthread_mutex_lock(&g_ring_lock);
+    m->id = g_next_id++;
+    g_ring[g_ring_next] = *m;
+    g_ring_next = (g_ring_next + 1) % BRIDGE_METRICS_RING;
+    if (g_ring_count < BRIDGE_METRICS_RING) g_ring_count++;
+    pthread_mutex_unlock(&g_ring_lock);
+}
+
+// Copy up to max finished requests, oldest first; returns how many were copied
+size_t bridge_metrics_snapshot(bridge_metrics *out, size_t max) {
+    pthread_mutex_lock(&g_ring_lock);
+    size_t count = g_ring_count < max ? g_ring_count : max;
+    size_t first = (g_ring_next + BRIDGE_METRICS_RING - count) % BRIDGE_METRICS_RING;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = g_ring[(first + i) % BRIDGE_METRICS_RING];
+    }
+    pthread_mutex_unlock(&g_ring_lock);
+    return count;
+}
+
+static double ns_to_ms(uint64_t ns) {
+    return (double) ns / 1000000.0;
+}
+
+/**
+ * Format m as a Server-Timing value ("startup;dur=0.41, globals;dur=0.08, ...").
+ * A non-final head (streaming, sent while the script still runs) has no
+ * shutdown phase and reports execute and total up to now.
+ */
+size_t bridge_metrics_server_timing(const bridge_metrics *m, int final, char *buf, size_t size) {
+    uint64_t phase_ns[BRIDGE_PHASE_COUNT];
+    memcpy(phase_ns, m->phase_ns, sizeof(phase_ns));
+
+    uint64_t total_ns = m->total_ns;
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!final && m == &ctx->metrics) {
+        uint64_t now = bridge_now_ns();
+        total_ns = now - ctx->metrics_start_ns;
+        if (ctx->execute_start_ns) {
+            uint64_t elapsed = now - ctx->execute_start_ns;
+            uint64_t excluded = phase_ns[BRIDGE_PHASE_COMPILE] + phase_ns[BRIDGE_PHASE_OUTPUT] - ctx->execute_excluded_ns;
+            phase_ns[BRIDGE_PHASE_EXECUTE] += elapsed > excluded ? elapsed - excluded : 0;
+        }
+    }
+
+    size_t length = 0;
+    for (int i = 0; i < BRIDGE_PHASE_COUNT && length < size; i++) {
+        if (!final && i == BRIDGE_PHASE_SHUTDOWN) continue;
+        length += snprintf(buf + length, size - length, "%s;dur=%.2f, ", phase_names[i], ns_to_ms(phase_ns[i]));
+    }
+    if (length < size) {
+        length += snprintf(buf + length, size - length, "total;dur=%.2f", ns_to_ms(total_ns));
+    }
+    return length < size ? length : size - 1;
+}
+
+// Plain malloc()ed text buffer: PHPBridge.metrics() runs on any Kotlin
+// thread, where the engine allocator must not be touched
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} text_buf;
+
+static void text_printf(text_buf *out, const char *format, ...) {
+    if (!out->data) return;
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(out->data + out->length, out->capacity - out->length, format, args);
+        va_end(args);
+        if (n < 0) return;
+        if (out->length + (size_t) n < out->capacity) {
+            out->length += (size_t) n;
+            return;
+        }
+
+        size_t capacity = out->capacity * 2 + (size_t) n;
+        char *data = realloc(out->data, capacity);
+        if (!data) return;
+        out->data = data;
+        out->capacity = capacity;
+    }
+}
+
+static void text_json_string(text_buf *out, const char *value) {
+    text_printf(out, "\"");
+    for (const unsigned char *p = (const unsigned char *) value; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            text_printf(out, "\\%c", *p);
+        } else if (*p < 0x20) {
+            text_printf(out, "\\u%04x", *p);
+        } else {
+            text_printf(out, "%c", *p);
+        }
+    }
+    text_printf(out, "\"");
+}
+
+/**
+ * The ring as a JSON array (oldest first) for PHPBridge.metrics().
+ * Returned string is malloc()ed; the caller frees it.
+ */
+char *bridge_metrics_json(void) {
+    bridge_metrics *items = malloc(sizeof(bridge_metrics) * BRIDGE_METRICS_RING);
+    if (!items) return NULL;
+    size_t count = bridge_metrics_snapshot(items, BRIDGE_METRICS_RING);
+
+    text_buf out = {malloc(4096), 0, 4096};
+    text_printf(&out, "[");
+    for (size_t i = 0; i < count; i++) {
+        bridge_metrics *m = &items[i];
+
+        text_printf(&out, "%s{\"id\":%llu,\"time\":%lld,\"method\":", i ? "," : "",
+                    (unsigned long long) m->id, (long long) m->started_at_ms);
+        text_json_string(&out, m->method);
+        text_printf(&out, ",\"uri\":");
+        text_json_string(&out, m->uri);
+        text_printf(&out, ",\"status\":%d,\"worker\":%s", m->status, m->worker ? "true" : "false");
+        for (int p = 0; p < BRIDGE_PHASE_COUNT; p++) {
+            text_printf(&out, ",\"%s_ms\":%.3f", phase_names[p], ns_to_ms(m->phase_ns[p]));
+        }
+        text_printf(&out, ",\"total_ms\":%.3f,\"peak_memory\":%zu,\"heap_size\":%zu,\"bytes_out\":%zu}",
+                    ns_to_ms(m->total_ns), m->peak_memory, m->heap_size, m->bytes_out);
+    }
+    text_printf(&out, "]");
+
+    free(items);
+    return out.data;
+}
@@ -0,0 +1,549 @@
+#include <android/log.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include "php_embed.h"
+#include <zend_observer.h>
+#include <zend_fibers.h>
+#include "PHP.h"
+
+#define LOG_TAG "PHP-Profiler"
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+// Function profiler
+// Opt-in (MVC_PROFILER=1 when the engine starts): observer begin/end hooks
+// keep a per-interpreter call stack and aggregate a call tree. After every
+// request the tree is written as folded stacks ("a;b;c <self µs>", the input
+// of flamegraph.pl / speedscope) to MVC_PROFILER_DIR, the hottest functions
+// are logged, and the last profile stays available to PHPBridge.lastProfile().
+// Observers can only be registered during module startup, so turning the
+// profiler on or off needs an engine restart; when off nothing is registered
+// and the VM runs without observer overhead.
+//
+// Every Fiber keeps its own frames: a fiber switch observer moves the frames
+// of a suspending Fiber off the stack and puts them back when it resumes, so
+// Native::parallel() tasks never end each other's frames. Time spent
+// suspended is not charged to the Fiber's frames.
+
+#define PROFILER_MAX_FUNCS 8192
+#define PROFILER_MAX_NODES 65536
+#define PROFILER_MAX_DEPTH 512
+#define PROFILER_TOP_FUNCS 10
+
+typedef struct {
+    char *name;
+    uint64_t calls;
+    uint64_t inclusive_ns;
+    uint64_t exclusive_ns;
+    uint32_t active;            // recursion depth; inclusive time counts the outermost call only
+} prof_func;
+
+typedef struct {
+    uint32_t parent;            // UINT32_MAX for a root
+    uint32_t func;
+    uint64_t self_ns;
+} prof_node;
+
+typedef struct {
+    uint32_t node;
+    const void *key;
+    uint64_t start_ns;
+    uint64_t child_ns;
+} prof_frame;
+
+// Open-addressed uint64 -> uint32 map; key 0 marks an empty slot
+typedef struct {
+    uint64_t *keys;
+    uint32_t *values;
+    uint32_t capacity;
+    uint32_t count;
+} prof_map;
+
+// Frames of one Fiber. A running Fiber's frames sit on the stack from base
+// up; a suspended one's are parked in frames.
+typedef struct prof_fiber {
+    struct prof_fiber *next;
+    zend_fiber_context *context;
+    uint32_t base;
+    int suspended;
+    prof_frame *frames;
+    uint32_t frame_count;
+    uint32_t overflow;
+    uint64_t suspended_ns;
+} prof_fiber;
+
+typedef struct bridge_profile {
+    prof_func *funcs;
+    uint32_t func_count;
+    prof_map func_map;          // function identity -> funcs index
+
+    prof_node *nodes;
+    uint32_t node_count;
+    prof_map node_map;          // (parent, func) -> nodes index
+
+    prof_frame stack[PROFILER_MAX_DEPTH];
+    uint32_t depth;
+    uint32_t overflow;          // open frames not recorded (too deep, tables full); nothing below them is either
+    prof_fiber *fibers;
+} bridge_profile;
+
+static int g_enabled = 0;
+static char g_dir[512];
+
+static char *g_last_profile = NULL;
+static pthread_mutex_t g_last_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int map_init(prof_map *map, uint32_t capacity) {
+    map->keys = calloc(capacity, sizeof(uint64_t));
+    map->values = malloc(capacity * sizeof(uint32_t));
+    map->capacity = capacity;
+    map->count = 0;
+    return map->keys && map->values;
+}
+
+static void map_clear(prof_map *map) {
+    memset(map->keys, 0, map->capacity * sizeof(uint64_t));
+    map->count = 0;
+}
+
+// Find key, or claim a slot for it (*found = 0); NULL when the map is at its
+// load limit and key is not in it
+static uint32_t *map_slot(prof_map *map, uint64_t key, int *found) {
+    uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+    uint32_t mask = map->capacity - 1;
+    for (uint32_t i = (uint32_t) (hash >> 32) & mask;; i = (i + 1) & mask) {
+        if (map->keys[i] == key) {
+            *found = 1;
+            return &map->values[i];
+        }
+        if (map->keys[i] == 0) {
+            *found = 0;
+            if (map->count >= map->capacity / 2) return NULL;
+            map->keys[i] = key;
+            map->count++;
+            return &map->values[i];
+        }
+    }
+}
+
+static bridge_profile *profile_get() {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (ctx->profile) return ctx->profile;
+
+    // Maps are sized at twice their entry limit (a power of two) and stop
+    // taking keys at half full, so probes stay short and always terminate
+    bridge_profile *p = calloc(1, sizeof(bridge_profile));
+    if (!p) return NULL;
+    p->funcs = malloc(PROFILER_MAX_FUNCS * sizeof(prof_func));
+    p->nodes = malloc(PROFILER_MAX_NODES * sizeof(prof_node));
+    if (!p->funcs || !p->nodes ||
+        !map_init(&p->func_map, PROFILER_MAX_FUNCS * 2) ||
+        !map_init(&p->node_map, PROFILER_MAX_NODES * 2)) {
+        LOGE("❌ Profiler allocation failed");
+        free(p->funcs);
+        free(p->nodes);
+        free(p->func_map.keys);
+        free(p->func_map.values);
+        free(p->node_map.keys);
+        free(p->node_map.values);
+        free(p);
+        return NULL;
+    }
+    ctx->profile = p;
+    return p;
+}
+
+// Copies of a closure share their opcodes, so user code is identified by those
+static const void *function_key(const zend_function *func) {
+    return func->type == ZEND_USER_FUNCTION ? (const void *) func->op_array.opcodes : (const void *) func;
+}
+
+/**
+ * Frame name for folded stacks: "Class::method", "function", or
+ * "{main file.php}" for the top-level code of a script or include. Shared
+ * with the sampler (bridge_sampler.c).
+ */
+void bridge_function_name(const zend_function *func, char *buf, size_t size) {
+    if (func->common.function_name) {
+        if (func->common.scope) {
+            snprintf(buf, size, "%s::%s", ZSTR_VAL(func->common.scope->name), ZSTR_VAL(func->common.function_name));
+        } else {
+            snprintf(buf, size, "%s", ZSTR_VAL(func->common.function_name));
+        }
+    } else if (func->type == ZEND_USER_FUNCTION && func->op_array.filename) {
+        const char *file = ZSTR_VAL(func->op_array.filename);
+        const char *base = strrchr(file, '/');
+        snprintf(buf, size, "{main %s}", base ? base + 1 : file);
+    } else {
+        snprintf(buf, size, "{unknown}");
+    }
+
+    // ';' separates frames in folded output, ' ' separates the count
+    for (char *c = buf; *c; c++) {
+        if (*c == ';' || *c == ' ') *c = '_';
+    }
+}
+
+static char *function_name(const zend_function *func) {
+    char buf[512];
+    bridge_function_name(func, buf, sizeof(buf));
+    return strdup(buf);
+}
+
+static uint32_t func_index(bridge_profile *p, const zend_function *func, const void *key) {
+    int found;
+    uint32_t *slot = map_slot(&p->func_map, (uint64_t) (uintptr_t) key, &found);
+    if (found) return *slot;
+    if (!slot) return UINT32_MAX;
+
+    prof_func *f = &p->funcs[p->func_count];
+    memset(f, 0, sizeof(*f));
+    f->name = function_name(func);
+    *slot = p->func_count++;
+    return *slot;
+}
+
+static uint32_t node_index(bridge_profile *p, uint32_t parent, uint32_t func) {
+    uint64_t key = ((uint64_t) (parent + 1) << 32) | (uint64_t) (func + 1);
+    int found;
+    uint32_t *slot = map_slot(&p->node_map, key, &found);
+    if (found) return *slot;
+    if (!slot) return UINT32_MAX;
+
+    prof_node *n = &p->nodes[p->node_count];
+    n->parent = parent;
+    n->func = func;
+    n->self_ns = 0;
+    *slot = p->node_count++;
+    return *slot;
+}
+
+static void profiler_fcall_begin(zend_execute_data *execute_data) {
+    bridge_profile *p = bridge_ctx()->profile;
+    if (!p) return;
+    if (p->overflow || p->depth >= PROFILER_MAX_DEPTH) {
+        p->overflow++;
+        return;
+    }
+
+    const zend_function *func = execute_data->func;
+    const void *key = function_key(func);
+    uint32_t parent = p->depth ? p->stack[p->depth - 1].node : UINT32_MAX;
+    uint32_t f = func_index(p, func, key);
+    uint32_t node = f == UINT32_MAX ? UINT32_MAX : node_index(p, parent, f);
+    if (node == UINT32_MAX) {
+        // Tables full: the call is not recorded and its time stays with the caller
+        p->overflow++;
+        return;
+    }
+
+    prof_frame *frame = &p->stack[p->depth++];
+    frame->node = node;
+    frame->key = key;
+    frame->child_ns = 0;
+    p->funcs[f].calls++;
+    p->funcs[f].active++;
+    frame->start_ns = bridge_now_ns();
+}
+
+// Account the frame on top of the stack as ended at now and pop it
+static void frame_pop(bridge_profile *p, uint64_t now) {
+    prof_frame *frame = &p->stack[p->depth - 1];
+    uint64_t elapsed = now - frame->start_ns;
+    uint64_t self = elapsed > frame->child_ns ? elapsed - frame->child_ns : 0;
+
+    prof_node *node = &p->nodes[frame->node];
+    prof_func *f = &p->funcs[node->func];
+    node->self_ns += self;
+    f->exclusive_ns += self;
+    if (f->active > 0 && --f->active == 0) {
+        f->inclusive_ns += elapsed;
+    }
+
+    p->depth--;
+    if (p->depth > 0) {
+        p->stack[p->depth - 1].child_ns += elapsed;
+    }
+}
+
+static void profiler_fcall_end(zend_execute_data *execute_data, zval *retval) {
+    uint64_t now = bridge_now_ns();
+    bridge_profile *p = bridge_ctx()->profile;
+    if (!p) return;
+    if (p->overflow) {
+        p->overflow--;
+        return;
+    }
+
+    // Frames left above ours (a bailout skipped their end) end with it
+    const void *key = function_key(execute_data->func);
+    uint32_t depth = p->depth;
+    while (depth > 0 && p->stack[depth - 1].key != key) depth--;
+    if (depth == 0) return;
+
+    while (p->depth >= depth) frame_pop(p, now);
+}
+
+static prof_fiber *fiber_find(bridge_profile *p, zend_fiber_context *context) {
+    for (prof_fiber *fiber = p->fibers; fiber; fiber = fiber->next) {
+        if (fiber->context == context) return fiber;
+    }
+    return NULL;
+}
+
+static void fiber_forget(bridge_profile *p, prof_fiber *fiber) {
+    prof_fiber **link = &p->fibers;
+    while (*link && *link != fiber) link = &(*link)->next;
+    if (*link) *link = fiber->next;
+    free(fiber->frames);
+    free(fiber);
+}
+
+static void fiber_free_all(bridge_profile *p) {
+    while (p->fibers) fiber_forget(p, p->fibers);
+}
+
+// Park the running frames of from, which is suspending back to its resumer
+static void fiber_park(bridge_profile *p, zend_fiber_context *from, uint64_t now) {
+    prof_fiber *fiber = fiber_find(p, from);
+    // Only the main context runs without a record; it never suspends
+    if (!fiber) return;
+
+    uint32_t base = fiber->base < p->depth ? fiber->base : p->depth;
+    if (from->status == ZEND_FIBER_STATUS_DEAD) {
+        while (p->depth > base) frame_pop(p, now);
+        fiber_forget(p, fiber);
+        return;
+    }
+
+    uint32_t count = p->depth - base;
+    free(fiber->frames);
+    fiber->frames = count ? malloc(count * sizeof(prof_frame)) : NULL;
+    if (count && !fiber->frames) {
+        // Nothing to park them in: the frames end here
+        while (p->depth > base) frame_pop(p, now);
+        count = 0;
+    } else if (count) {
+        memcpy(fiber->frames, &p->stack[base], count * sizeof(prof_frame));
+    }
+    fiber->frame_count = count;
+    fiber->overflow = p->overflow;
+    fiber->suspended = 1;
+    fiber->suspended_ns = now;
+    p->depth = base;
+    p->overflow = 0;
+}
+
+// Put the parked frames of a resuming Fiber back on the stack
+static void fiber_restore(bridge_profile *p, prof_fiber *fiber, uint64_t now) {
+    fiber->base = p->depth;
+    fiber->suspended = 0;
+
+    uint64_t paused = now - fiber->suspended_ns;
+    uint32_t room = PROFILER_MAX_DEPTH - p->depth;
+    uint32_t count = fiber->frame_count < room ? fiber->frame_count : room;
+    for (uint32_t i = 0; i < count; i++) {
+        prof_frame *frame = &p->stack[p->depth++];
+        *frame = fiber->frames[i];
+        frame->start_ns += paused;
+    }
+    // Frames that no longer fit are not recorded, like any too deep call
+    p->overflow = fiber->overflow + (fiber->frame_count - count);
+
+    free(fiber->frames);
+    fiber->frames = NULL;
+    fiber->frame_count = 0;
+}
+
+static void profiler_fiber_switch(zend_fiber_context *from, zend_fiber_context *to) {
+    uint64_t now = bridge_now_ns();
+    bridge_profile *p = bridge_ctx()->profile;
+    if (!p) return;
+
+    prof_fiber *target = fiber_find(p, to);
+    if (to->status == ZEND_FIBER_STATUS_INIT) {
+        // A Fiber starting: its frames go on top of whoever started it
+        if (!target) {
+            target = calloc(1, sizeof(prof_fiber));
+            if (!target) return;
+            target->context = to;
+            target->next = p->fibers;
+            p->fibers = target;
+        }
+        target->base = p->depth;
+        target->suspended = 0;
+        return;
+    }
+    if (target && target->suspended) {
+        fiber_restore(p, target, now);
+        return;
+    }
+
+    // to is running below from: from is suspending or has finished
+    fiber_park(p, from, now);
+}
+
+static zend_observer_fcall_handlers profiler_observer_init(zend_execute_data *execute_data) {
+    return (zend_observer_fcall_handlers) {profiler_fcall_begin, profiler_fcall_end};
+}
+
+int bridge_profiler_enabled(void) {
+    return g_enabled;
+}
+
+// Called from the nativephp extension's MINIT, the only time observers can register
+void bridge_profiler_startup(void) {
+    const char *flag = getenv("MVC_PROFILER");
+    g_enabled = flag && (strcmp(flag, "1") == 0 || strcasecmp(flag, "true") == 0);
+    if (!g_enabled) return;
+
+    const char *dir = getenv("MVC_PROFILER_DIR");
+    snprintf(g_dir, sizeof(g_dir), "%s", dir ? dir : "");
+    if (g_dir[0]) mkdir(g_dir, 0700);
+
+    zend_observer_fcall_register(profiler_observer_init);
+    zend_observer_fiber_switch_register(profiler_fiber_switch);
+    LOGI("🔬 Function profiler enabled (output: %s)", g_dir[0] ? g_dir : "memory only");
+}
+
+static void profile_reset(bridge_profile *p) {
+    for (uint32_t i = 0; i < p->func_count; i++) {
+        free(p->funcs[i].name);
+    }
+    p->func_count = 0;
+    p->node_count = 0;
+    p->depth = 0;
+    p->overflow = 0;
+    fiber_free_all(p);
+    map_clear(&p->func_map);
+    map_clear(&p->node_map);
+}
+
+void bridge_profiler_begin(void) {
+    if (!g_enabled) return;
+    bridge_profile *p = profile_get();
+    if (p) profile_reset(p);
+}
+
+// Append "frame;frame;frame" for node to buf (root first); returns new length
+static size_t folded_path(bridge_profile *p, uint32_t node, char *buf, size_t size) {
+    uint32_t chain[PROFILER_MAX_DEPTH];
+    uint32_t n = 0;
+    for (uint32_t i = node; i != UINT32_MAX && n < PROFILER_MAX_DEPTH; i = p->nodes[i].parent) {
+        chain[n++] = i;
+    }
+
+    size_t length = 0;
+    while (n > 0 && length < size) {
+        const char *name = p->funcs[p->nodes[chain[--n]].func].name;
+        length += snprintf(buf + length, size - length, "%s%s", length ? ";" : "", name);
+    }
+    return length < size ? length : size - 1;
+}
+
+static char *folded_output(bridge_profile *p) {
+    size_t capacity = 64 * 1024;
+    size_t length = 0;
+    char *out = malloc(capacity);
+    if (!out) return NULL;
+    out[0] = '\0';
+
+    char line[4096];
+    for (uint32_t i = 0; i < p->node_count; i++) {
+        uint64_t self_us = p->nodes[i].self_ns / 1000;
+        if (self_us == 0) continue;
+
+        size_t n = folded_path(p, i, line, sizeof(line) - 32);
+        n += snprintf(line + n, sizeof(line) - n, " %llu\n", (unsigned long long) self_us);
+
+        if (length + n + 1 > capacity) {
+            while (length + n + 1 > capacity) capacity *= 2;
+            char *grown = realloc(out, capacity);
+            if (!grown) break;
+            out = grown;
+        }
+        memcpy(out + length, line, n + 1);
+        length += n;
+    }
+    return out;
+}
+
+static void log_top_functions(bridge_profile *p, const bridge_metrics *m) {
+    uint32_t top[PROFILER_TOP_FUNCS];
+    uint32_t count = 0;
+
+    // Keep top[] sorted by exclusive time, largest first
+    for (uint32_t i = 0; i < p->func_count; i++) {
+        uint32_t pos;
+        if (count < PROFILER_TOP_FUNCS) {
+            pos = count++;
+        } else if (p->funcs[i].exclusive_ns > p->funcs[top[count - 1]].exclusive_ns) {
+            pos = count - 1;
+        } else {
+            continue;
+        }
+        while (pos > 0 && p->funcs[top[pos - 1]].exclusive_ns < p->funcs[i].exclusive_ns) {
+            top[pos] = top[pos - 1];
+            pos--;
+        }
+        top[pos] = i;
+    }
+
+    LOGI("🔬 %s %s: %u functions, %u call paths", m->method, m->uri, p->func_count, p->node_count);
+    for (uint32_t i = 0; i < count; i++) {
+        prof_func *f = &p->funcs[top[i]];
+        LOGI("🔬   %8.2fms self %8.2fms incl %6llu× %s",
+             f->exclusive_ns / 1000000.0, f->inclusive_ns / 1000000.0, (unsigned long long) f->calls, f->name);
+    }
+}
+
+static void write_profile(const char *folded, const bridge_metrics *m) {
+    if (!g_dir[0]) return;
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s", m->uri[0] ? m->uri : "request");
+    for (char *c = name; *c; c++) {
+        if (!isalnum((unsigned char) *c) && *c != '-' && *c != '.') *c = '_';
+    }
+
+    char path[768];
+    snprintf(path, sizeof(path), "%s/%06llu-%s.folded", g_dir, (unsigned long long) m->id, name);
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        LOGE("❌ Could not write profile %s", path);
+        return;
+    }
+    fputs(folded, file);
+    fclose(file);
+}
+
+// Dump the finished request's profile; m is its record from bridge_metrics_end()
+void bridge_profiler_end(const bridge_metrics *m) {
+    if (!g_enabled) return;
+    bridge_profile *p = bridge_ctx()->profile;
+    if (!p || p->node_count == 0) return;
+
+    char *folded = folded_output(p);
+    if (!folded) return;
+
+    log_top_functions(p, m);
+    write_profile(folded, m);
+
+    pthread_mutex_lock(&g_last_lock);
+    free(g_last_profile);
+    g_last_profile = folded;
+    pthread_mutex_unlock(&g_last_lock);
+}
+
+// Folded stacks of the most recently profiled request (malloc()ed copy), or NULL
+char *bridge_profiler_last(void) {
+    pthread_mutex_lock(&g_last_lock);
+    char *copy = g_last_profile ? strdup(g_last_profile) : NULL;
+    pthread_mutex_unlock(&g_last_lock);
+    return copy;
+}
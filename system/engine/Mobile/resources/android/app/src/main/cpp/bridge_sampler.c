@@ -0,0 +1,306 @@
+#include <android/log.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "php_embed.h"
+#include "PHP.h"
+
+#define LOG_TAG "PHP-Sampler"
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+// Sampling profiler
+// Opt-in (MVC_SAMPLER=1 when the engine starts, MVC_SAMPLER_INTERVAL_MS
+// between samples, 10 by default): a timer thread raises EG(vm_interrupt) of
+// every interpreter that is serving a request. The VM answers at its next safe
+// point (function entry, loop back-edge, return from an internal call) by
+// calling zend_interrupt_function, where the current PHP stack is counted
+// under the request's route. Nothing runs per call, so the cost is one stack
+// walk per sample. Time inside internal functions is attributed to the PHP
+// frame that called them. The histogram is read as folded stacks through
+// PHPBridge.samplerProfile().
+
+#define SAMPLER_MAX_SLOTS 8
+#define SAMPLER_MAX_FRAMES 128
+#define SAMPLER_LEAF_FRAMES 32
+#define SAMPLER_MAX_STACKS 16384
+#define SAMPLER_BUCKETS 4096
+
+typedef struct {
+    zend_atomic_bool *vm_interrupt;     // EG(vm_interrupt) of the interpreter thread
+    int active;                         // serving a request
+    int pending;                        // sample requested, not yet taken
+    char route[96];
+} sampler_slot;
+
+typedef struct sampler_stack {
+    struct sampler_stack *next;
+    uint32_t hash;
+    uint64_t count;
+    char key[];                         // "route;frame;frame"
+} sampler_stack;
+
+static int g_enabled = 0;
+static unsigned int g_interval_ms = 10;
+
+static sampler_slot g_slots[SAMPLER_MAX_SLOTS];
+static int g_slot_count = 0;
+static pthread_mutex_t g_slots_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t g_timer;
+static volatile int g_running = 0;
+
+static sampler_stack *g_buckets[SAMPLER_BUCKETS];
+static size_t g_stack_count = 0;
+static uint64_t g_samples = 0;
+static uint64_t g_dropped = 0;
+static pthread_mutex_t g_hist_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Chained while the engine runs; restored at module shutdown
+static void (*prev_interrupt_function)(zend_execute_data *execute_data) = NULL;
+
+static uint32_t hash_key(const char *key) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *) key; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+static void histogram_add(const char *key) {
+    uint32_t hash = hash_key(key);
+    sampler_stack **bucket = &g_buckets[hash % SAMPLER_BUCKETS];
+
+    pthread_mutex_lock(&g_hist_lock);
+    g_samples++;
+    for (sampler_stack *s = *bucket; s; s = s->next) {
+        if (s->hash == hash && strcmp(s->key, key) == 0) {
+            s->count++;
+            pthread_mutex_unlock(&g_hist_lock);
+            return;
+        }
+    }
+
+    size_t length = strlen(key);
+    sampler_stack *s = g_stack_count < SAMPLER_MAX_STACKS ? malloc(sizeof(sampler_stack) + length + 1) : NULL;
+    if (!s) {
+        g_dropped++;
+        pthread_mutex_unlock(&g_hist_lock);
+        return;
+    }
+    s->hash = hash;
+    s->count = 1;
+    memcpy(s->key, key, length + 1);
+    s->next = *bucket;
+    *bucket = s;
+    g_stack_count++;
+    pthread_mutex_unlock(&g_hist_lock);
+}
+
+static void histogram_clear_locked(void) {
+    for (size_t i = 0; i < SAMPLER_BUCKETS; i++) {
+        sampler_stack *s = g_buckets[i];
+        while (s) {
+            sampler_stack *next = s->next;
+            free(s);
+            s = next;
+        }
+        g_buckets[i] = NULL;
+    }
+    g_stack_count = 0;
+    g_samples = 0;
+    g_dropped = 0;
+}
+
+// Record the stack ending at execute_data as "route;root;...;leaf". A stack
+// deeper than SAMPLER_MAX_FRAMES keeps its root end and its leaf end with a
+// "[truncated]" frame where the middle was cut, so the sample still sits
+// under its real root.
+static void take_sample(const char *route, zend_execute_data *execute_data) {
+    const zend_function *leaf[SAMPLER_LEAF_FRAMES];
+    const zend_function *root[SAMPLER_MAX_FRAMES - SAMPLER_LEAF_FRAMES];
+    const int root_size = SAMPLER_MAX_FRAMES - SAMPLER_LEAF_FRAMES;
+    int leaf_depth = 0;
+    int total = 0;
+
+    // The leaf end fills leaf[]; everything above it cycles through root[],
+    // which ends up holding the outermost frames
+    for (zend_execute_data *ex = execute_data; ex; ex = ex->prev_execute_data) {
+        if (!ex->func) continue;
+        if (leaf_depth < SAMPLER_LEAF_FRAMES) {
+            leaf[leaf_depth++] = ex->func;
+        } else {
+            root[(total - SAMPLER_LEAF_FRAMES) % root_size] = ex->func;
+        }
+        total++;
+    }
+    if (total == 0) return;
+
+    int root_depth = total - leaf_depth < root_size ? total - leaf_depth : root_size;
+    int truncated = total > SAMPLER_MAX_FRAMES;
+
+    char key[4096];
+    size_t length = snprintf(key, sizeof(key), "%s", route);
+    char name[256];
+    // Outermost frame first: the last one stored in root[], walking back
+    for (int i = 0; i < root_depth && length < sizeof(key); i++) {
+        int index = ((total - SAMPLER_LEAF_FRAMES - 1 - i) % root_size + root_size) % root_size;
+        bridge_function_name(root[index], name, sizeof(name));
+        length += snprintf(key + length, sizeof(key) - length, ";%s", name);
+    }
+    if (truncated && length < sizeof(key)) {
+        length += snprintf(key + length, sizeof(key) - length, ";[truncated]");
+    }
+    while (leaf_depth > 0 && length < sizeof(key)) {
+        bridge_function_name(leaf[--leaf_depth], name, sizeof(name));
+        length += snprintf(key + length, sizeof(key) - length, ";%s", name);
+    }
+    histogram_add(key);
+}
+
+static void sampler_interrupt(zend_execute_data *execute_data) {
+    int slot = bridge_ctx()->sampler_slot;
+    if (slot > 0 && __atomic_exchange_n(&g_slots[slot - 1].pending, 0, __ATOMIC_ACQ_REL)) {
+        take_sample(g_slots[slot - 1].route, execute_data);
+    }
+    if (prev_interrupt_function) {
+        prev_interrupt_function(execute_data);
+    }
+}
+
+static void *sampler_timer(void *arg) {
+    struct timespec interval = {g_interval_ms / 1000, (long) (g_interval_ms % 1000) * 1000000L};
+    while (g_running) {
+        nanosleep(&interval, NULL);
+
+        pthread_mutex_lock(&g_slots_lock);
+        for (int i = 0; i < g_slot_count; i++) {
+            sampler_slot *slot = &g_slots[i];
+            if (!slot->active) continue;
+            __atomic_store_n(&slot->pending, 1, __ATOMIC_RELEASE);
+            zend_atomic_bool_store(slot->vm_interrupt, true);
+        }
+        pthread_mutex_unlock(&g_slots_lock);
+    }
+    return NULL;
+}
+
+int bridge_sampler_enabled(void) {
+    return g_enabled;
+}
+
+// Called from the nativephp extension's MINIT
+void bridge_sampler_startup(void) {
+    const char *flag = getenv("MVC_SAMPLER");
+    g_enabled = flag && (strcmp(flag, "1") == 0 || strcasecmp(flag, "true") == 0);
+    if (!g_enabled) return;
+
+    const char *interval = getenv("MVC_SAMPLER_INTERVAL_MS");
+    int ms = interval ? atoi(interval) : 0;
+    g_interval_ms = ms > 0 && ms <= 1000 ? (unsigned int) ms : 10;
+
+    prev_interrupt_function = zend_interrupt_function;
+    zend_interrupt_function = sampler_interrupt;
+
+    g_running = 1;
+    if (pthread_create(&g_timer, NULL, sampler_timer, NULL) != 0) {
+        LOGE("❌ Could not start sampler thread");
+        g_running = 0;
+        zend_interrupt_function = prev_interrupt_function;
+        prev_interrupt_function = NULL;
+        g_enabled = 0;
+        return;
+    }
+    LOGI("📈 Sampling profiler enabled (every %ums)", g_interval_ms);
+}
+
+void bridge_sampler_shutdown(void) {
+    if (!g_enabled) return;
+
+    g_running = 0;
+    pthread_join(g_timer, NULL);
+
+    pthread_mutex_lock(&g_slots_lock);
+    g_slot_count = 0;
+    pthread_mutex_unlock(&g_slots_lock);
+
+    zend_interrupt_function = prev_interrupt_function;
+    prev_interrupt_function = NULL;
+    g_enabled = 0;
+}
+
+// Start sampling this interpreter for req; samples are filed under its
+// method and path (query string dropped so routes aggregate)
+void bridge_sampler_begin(bridge_request *req) {
+    if (!g_enabled) return;
+    bridge_request_ctx *ctx = bridge_ctx();
+
+    pthread_mutex_lock(&g_slots_lock);
+    if (ctx->sampler_slot == 0) {
+        if (g_slot_count >= SAMPLER_MAX_SLOTS) {
+            pthread_mutex_unlock(&g_slots_lock);
+            return;
+        }
+        ctx->sampler_slot = ++g_slot_count;
+    }
+
+    sampler_slot *slot = &g_slots[ctx->sampler_slot - 1];
+    slot->vm_interrupt = &EG(vm_interrupt);
+    const char *uri = req && req->uri ? req->uri : "";
+    size_t path = strcspn(uri, "?");
+    snprintf(slot->route, sizeof(slot->route), "%s:%.*s",
+             req && req->method ? req->method : "GET", (int) path, uri);
+    for (char *c = slot->route; *c; c++) {
+        if (*c == ';' || *c == ' ') *c = '_';
+    }
+    slot->pending = 0;
+    slot->active = 1;
+    pthread_mutex_unlock(&g_slots_lock);
+}
+
+void bridge_sampler_end(void) {
+    if (!g_enabled) return;
+    int index = bridge_ctx()->sampler_slot;
+    if (index == 0) return;
+
+    pthread_mutex_lock(&g_slots_lock);
+    g_slots[index - 1].active = 0;
+    g_slots[index - 1].pending = 0;
+    pthread_mutex_unlock(&g_slots_lock);
+}
+
+/**
+ * The histogram as folded stacks ("GET:/albums;{main index.php};App\\Foo::bar 42"),
+ * one line per distinct stack with its sample count. reset clears it
+ * afterwards. Returned string is malloc()ed; NULL when the sampler is off.
+ */
+char *bridge_sampler_folded(int reset) {
+    if (!g_enabled) return NULL;
+
+    pthread_mutex_lock(&g_hist_lock);
+    size_t capacity = 128;
+    for (size_t i = 0; i < SAMPLER_BUCKETS; i++) {
+        for (sampler_stack *s = g_buckets[i]; s; s = s->next) {
+            capacity += strlen(s->key) + 24;
+        }
+    }
+
+    char *out = malloc(capacity);
+    if (out) {
+        size_t length = 0;
+        for (size_t i = 0; i < SAMPLER_BUCKETS; i++) {
+            for (sampler_stack *s = g_buckets[i]; s; s = s->next) {
+                length += snprintf(out + length, capacity - length, "%s %llu\n", s->key, (unsigned long long) s->count);
+            }
+        }
+        out[length] = '\0';
+        LOGI("📈 %llu samples, %zu stacks, %llu dropped",
+             (unsigned long long) g_samples, g_stack_count, (unsigned long long) g_dropped);
+    }
+    if (reset) histogram_clear_locked();
+    pthread_mutex_unlock(&g_hist_lock);
+    return out;
+}
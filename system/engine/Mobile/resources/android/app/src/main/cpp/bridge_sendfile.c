@@ -0,0 +1,172 @@
+#include <android/log.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "PHP.h"
+
+#define LOG_TAG "PHP-Sendfile"
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+// File responses
+// Response::file() only sends headers, one of them "X-Sendfile: /abs/path".
+// The bridge takes that header out of the head, opens the file and sends it
+// itself: sendfile(2) into the pipe of a streamed response, or, for a buffered
+// one, the descriptor goes to PHPResponse and Kotlin reads the slice from it. The file never passes through PHP
+// memory, ub_write or the output buffer. A 206 status with a
+// "Content-Range: bytes start-end/size" header (Response::stream() range
+// handling) limits the copy to that slice.
+
+#define SENDFILE_HEADER "X-Sendfile"
+#define SENDFILE_CHUNK (1024 * 1024)
+
+void bridge_sendfile_reset(void) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (ctx->sendfile_active) {
+        close(ctx->sendfile_fd);
+    }
+    free(ctx->sendfile_path);
+    ctx->sendfile_path = NULL;
+    ctx->sendfile_active = 0;
+    ctx->sendfile_fd = -1;
+    ctx->sendfile_offset = 0;
+    ctx->sendfile_length = 0;
+}
+
+/**
+ * Consume an X-Sendfile response header. Returns 1 when name is that header
+ * (it must not reach the WebView), 0 for any other header.
+ */
+int bridge_sendfile_header(const char *name, size_t name_length, const char *value, size_t value_length) {
+    if (name_length != sizeof(SENDFILE_HEADER) - 1 || strncasecmp(name, SENDFILE_HEADER, name_length) != 0) {
+        return 0;
+    }
+
+    bridge_sendfile_reset();
+    bridge_request_ctx *ctx = bridge_ctx();
+
+    char path[1024];
+    if (value_length == 0 || value_length >= sizeof(path)) {
+        LOGE("❌ Ignoring X-Sendfile with an empty or oversized path");
+        ctx->status_code = 500;
+        return 1;
+    }
+    memcpy(path, value, value_length);
+    path[value_length] = '\0';
+
+    struct stat st;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0 && (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))) {
+        close(fd);
+        fd = -1;
+    }
+    if (fd < 0) {
+        LOGE("❌ X-Sendfile target not readable: %s", path);
+        ctx->status_code = 404;
+        return 1;
+    }
+
+    ctx->sendfile_active = 1;
+    ctx->sendfile_fd = fd;
+    ctx->sendfile_path = strdup(path);
+    ctx->sendfile_offset = 0;
+    ctx->sendfile_length = (size_t) st.st_size;
+    return 1;
+}
+
+// Value of a captured response header, or NULL
+static const char *find_header(bridge_request_ctx *ctx, const char *wanted) {
+    const char *p = ctx->headers;
+    for (size_t i = 0; i < ctx->header_count; i++) {
+        const char *name = p;
+        const char *value = name + strlen(name) + 1;
+        p = value + strlen(value) + 1;
+        if (strcasecmp(name, wanted) == 0) return value;
+    }
+    return NULL;
+}
+
+// Once the whole head is captured: narrow the copy to a 206's Content-Range
+void bridge_sendfile_resolve(void) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!ctx->sendfile_active) return;
+
+    if (ctx->status_code == 206) {
+        const char *range = find_header(ctx, "Content-Range");
+        unsigned long long start, end;
+        if (!range || sscanf(range, "bytes %llu-%llu", &start, &end) != 2 ||
+            end < start || end >= (unsigned long long) ctx->sendfile_length) {
+            LOGE("❌ 206 file response without a usable Content-Range, sending nothing");
+            ctx->sendfile_length = 0;
+        } else {
+            ctx->sendfile_offset = (off_t) start;
+            ctx->sendfile_length = (size_t) (end - start + 1);
+        }
+    } else if (ctx->status_code != 200) {
+        // 304, 416 and friends carry no body
+        ctx->sendfile_length = 0;
+    }
+
+    // The copy happens after the request's metrics are closed
+    ctx->metrics.bytes_out += ctx->sendfile_length;
+}
+
+/**
+ * Hand the pending file slice to the caller: returns the descriptor (now owned
+ * by the caller) with the slice in *offset / *length, and forgets the file.
+ * Returns -1 when there is nothing to send, or when the file shrank below the
+ * slice since X-Sendfile was read, since a short body under the captured
+ * Content-Length would be a broken response.
+ */
+int bridge_sendfile_detach(off_t *offset, size_t *length) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!ctx->sendfile_active || ctx->sendfile_length == 0) return -1;
+
+    struct stat st;
+    if (fstat(ctx->sendfile_fd, &st) != 0 ||
+        (unsigned long long) st.st_size < (unsigned long long) ctx->sendfile_offset + ctx->sendfile_length) {
+        LOGE("❌ File response changed on disk: %s", ctx->sendfile_path ? ctx->sendfile_path : "?");
+        bridge_sendfile_reset();
+        return -1;
+    }
+
+    int fd = ctx->sendfile_fd;
+    *offset = ctx->sendfile_offset;
+    *length = ctx->sendfile_length;
+
+    ctx->sendfile_active = 0;
+    ctx->sendfile_fd = -1;
+    bridge_sendfile_reset();
+    return fd;
+}
+
+/**
+ * Copy the pending file slice into out_fd (the streamed response pipe) with
+ * sendfile(2) and release the file. A reader that went away ends the copy.
+ */
+void bridge_sendfile_pipe(int out_fd) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!ctx->sendfile_active) return;
+
+    off_t offset = ctx->sendfile_offset;
+    size_t remaining = ctx->sendfile_length;
+
+    while (out_fd >= 0 && remaining > 0) {
+        ssize_t n = sendfile(out_fd, ctx->sendfile_fd, &offset,
+                             remaining < SENDFILE_CHUNK ? remaining : SENDFILE_CHUNK);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            LOGI("⚠️ File response stopped with %zu bytes left (%s)", remaining, n < 0 ? strerror(errno) : "EOF");
+            break;
+        }
+        remaining -= (size_t) n;
+    }
+
+    bridge_sendfile_reset();
+}
@@ -0,0 +1,235 @@
+#include <android/log.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "php_embed.h"
+#include "PHP.h"
+
+#define LOG_TAG "PHP-Watchdog"
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+// Request watchdog
+// max_execution_time relies on SIGPROF timers, which the embed SAPI cannot
+// count on under ART. Instead every request gets a deadline and one thread
+// watches them all: when a deadline passes it sets EG(timed_out) and
+// EG(vm_interrupt) of that interpreter, the VM raises "Maximum execution time
+// exceeded" at its next safe point and the request bails out like any fatal
+// error. The bridge then answers 503. A script blocked inside an internal
+// function (sleep, a socket read) is stopped once that call returns.
+//
+// The deadline is MVC_REQUEST_TIMEOUT_MS (30 s by default, 0 = none), an
+// X-Bridge-Timeout request header in milliseconds, or whatever PHP sets with
+// nativephp_deadline() (Router ->timeout()) while the request runs.
+
+#define WATCHDOG_MAX_SLOTS 8
+#define WATCHDOG_DEFAULT_MS 30000
+#define WATCHDOG_HEADER "X-Bridge-Timeout"
+
+typedef struct {
+    zend_atomic_bool *vm_interrupt;
+    zend_atomic_bool *timed_out;
+    zend_long *timeout_seconds;
+    uint64_t deadline_ns;           // 0 when disarmed
+    uint64_t started_ns;
+    int fired;
+} watchdog_slot;
+
+static watchdog_slot g_slots[WATCHDOG_MAX_SLOTS];
+static int g_slot_count = 0;
+static uint64_t g_default_ms = WATCHDOG_DEFAULT_MS;
+
+static pthread_t g_thread;
+static int g_running = 0;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wake;
+
+static void *watchdog_thread(void *arg) {
+    pthread_mutex_lock(&g_lock);
+    while (g_running) {
+        uint64_t now = bridge_now_ns();
+        uint64_t next = 0;
+
+        for (int i = 0; i < g_slot_count; i++) {
+            watchdog_slot *slot = &g_slots[i];
+            if (!slot->deadline_ns || slot->fired) continue;
+
+            if (slot->deadline_ns <= now) {
+                slot->fired = 1;
+                // Only read by the "Maximum execution time of %d seconds" fatal
+                *slot->timeout_seconds = (zend_long) ((slot->deadline_ns - slot->started_ns + 999999999ull) / 1000000000ull);
+                zend_atomic_bool_store(slot->timed_out, true);
+                zend_atomic_bool_store(slot->vm_interrupt, true);
+                LOGE("⏰ Interpreter %d exceeded its deadline after %llums, interrupting", i + 1,
+                     (unsigned long long) ((now - slot->started_ns) / 1000000));
+            } else if (!next || slot->deadline_ns < next) {
+                next = slot->deadline_ns;
+            }
+        }
+
+        if (!next) {
+            pthread_cond_wait(&g_wake, &g_lock);
+        } else {
+            struct timespec until = {(time_t) (next / 1000000000ull), (long) (next % 1000000000ull)};
+            pthread_cond_timedwait(&g_wake, &g_lock, &until);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return NULL;
+}
+
+// Called from the nativephp extension's MINIT
+void bridge_watchdog_startup(void) {
+    const char *timeout = getenv("MVC_REQUEST_TIMEOUT_MS");
+    g_default_ms = timeout && *timeout ? (uint64_t) strtoull(timeout, NULL, 10) : WATCHDOG_DEFAULT_MS;
+
+    // Deadlines are CLOCK_MONOTONIC (bridge_now_ns), so the wait must be too
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    g_running = 1;
+    if (pthread_create(&g_thread, NULL, watchdog_thread, NULL) != 0) {
+        LOGE("❌ Could not start request watchdog, requests run without a time limit");
+        g_running = 0;
+        return;
+    }
+    LOGI("⏰ Request watchdog started (default limit %llums)", (unsigned long long) g_default_ms);
+}
+
+void bridge_watchdog_shutdown(void) {
+    pthread_mutex_lock(&g_lock);
+    int running = g_running;
+    g_running = 0;
+    g_slot_count = 0;
+    pthread_cond_signal(&g_wake);
+    pthread_mutex_unlock(&g_lock);
+
+    if (running) pthread_join(g_thread, NULL);
+    pthread_cond_destroy(&g_wake);
+}
+
+static uint64_t request_timeout_ms(bridge_request *req) {
+    for (size_t i = 0; req && i < req->header_count; i++) {
+        if (strcasecmp(req->header_names[i], WATCHDOG_HEADER) == 0) {
+            return (uint64_t) strtoull(req->header_values[i], NULL, 10);
+        }
+    }
+    return g_default_ms;
+}
+
+// Point the calling interpreter's slot at a new deadline; timeout_ms 0 disarms
+static void slot_set_deadline(uint64_t timeout_ms) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (ctx->watchdog_slot == 0) return;
+
+    pthread_mutex_lock(&g_lock);
+    watchdog_slot *slot = &g_slots[ctx->watchdog_slot - 1];
+    if (!slot->fired) {
+        slot->deadline_ns = timeout_ms ? bridge_now_ns() + timeout_ms * 1000000ull : 0;
+        pthread_cond_signal(&g_wake);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+// Start the clock for req on the calling interpreter
+void bridge_watchdog_arm(bridge_request *req) {
+    if (!g_running) return;
+    bridge_request_ctx *ctx = bridge_ctx();
+
+    pthread_mutex_lock(&g_lock);
+    if (ctx->watchdog_slot == 0) {
+        if (g_slot_count >= WATCHDOG_MAX_SLOTS) {
+            pthread_mutex_unlock(&g_lock);
+            return;
+        }
+        ctx->watchdog_slot = ++g_slot_count;
+    }
+    watchdog_slot *slot = &g_slots[ctx->watchdog_slot - 1];
+    slot->vm_interrupt = &EG(vm_interrupt);
+    slot->timed_out = &EG(timed_out);
+    slot->timeout_seconds = &EG(timeout_seconds);
+    slot->started_ns = bridge_now_ns();
+    slot->deadline_ns = 0;
+    slot->fired = 0;
+    pthread_mutex_unlock(&g_lock);
+
+    slot_set_deadline(request_timeout_ms(req));
+}
+
+/**
+ * Move the running request's deadline to timeout_ms from now (0 = no limit).
+ * Backs nativephp_deadline(); returns 0 when no request is being watched.
+ */
+int bridge_watchdog_extend(uint64_t timeout_ms) {
+    if (!g_running || bridge_ctx()->watchdog_slot == 0) return 0;
+    slot_set_deadline(timeout_ms);
+    return 1;
+}
+
+/**
+ * Milliseconds left before the running request's deadline, or -1 when it has
+ * none. Blocking native waits (nativephp_await) cap themselves with it, since
+ * the watchdog cannot interrupt code running in Java.
+ */
+int64_t bridge_watchdog_remaining_ms(void) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!g_running || ctx->watchdog_slot == 0) return -1;
+
+    pthread_mutex_lock(&g_lock);
+    watchdog_slot *slot = &g_slots[ctx->watchdog_slot - 1];
+    int64_t remaining = -1;
+    if (slot->fired) {
+        remaining = 0;
+    } else if (slot->deadline_ns) {
+        uint64_t now = bridge_now_ns();
+        remaining = slot->deadline_ns > now ? (int64_t) ((slot->deadline_ns - now) / 1000000) : 0;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return remaining;
+}
+
+/**
+ * Whether the watchdog actually stopped the running script: its deadline
+ * fired and the VM consumed EG(timed_out) at a safe point (zend_timeout()
+ * clears the flag before raising the fatal). Call it right after the script
+ * ran, before request shutdown. A deadline that passed after the script's
+ * last safe point leaves the flag set, and the response is complete.
+ */
+int bridge_watchdog_interrupted(void) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!g_running || ctx->watchdog_slot == 0) return 0;
+
+    pthread_mutex_lock(&g_lock);
+    int interrupted = g_slots[ctx->watchdog_slot - 1].fired && !zend_atomic_bool_load(&EG(timed_out));
+    pthread_mutex_unlock(&g_lock);
+    return interrupted;
+}
+
+/**
+ * Stop the clock. Returns 1 when the deadline fired during this request and
+ * stores how long the request had run in *elapsed_ms.
+ */
+int bridge_watchdog_disarm(uint64_t *elapsed_ms) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!g_running || ctx->watchdog_slot == 0) return 0;
+
+    pthread_mutex_lock(&g_lock);
+    watchdog_slot *slot = &g_slots[ctx->watchdog_slot - 1];
+    int fired = slot->fired;
+    if (elapsed_ms) *elapsed_ms = (bridge_now_ns() - slot->started_ns) / 1000000;
+    slot->deadline_ns = 0;
+    slot->fired = 0;
+
+    // A deadline that fired after the script's last safe point must not
+    // abort the next request on this interpreter
+    zend_atomic_bool_store(&EG(timed_out), false);
+    // Request startup arms a SIGPROF timer from a non-zero timeout_seconds
+    EG(timeout_seconds) = 0;
+    pthread_mutex_unlock(&g_lock);
+    return fired;
+}
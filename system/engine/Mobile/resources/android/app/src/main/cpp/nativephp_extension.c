@@ -0,0 +1,735 @@
+#include <jni.h>
+#include <android/log.h>
+#include "php_embed.h"
+#include "PHP.h"
+#include <zend_exceptions.h>
+
+#define LOG_TAG "NativePHP-Ext"
+#define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__))
+#define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+// Nested arrays deeper than this are passed as null rather than recursing forever
+#define MARSHAL_MAX_DEPTH 64
+
+// Java types used for marshalling, resolved once in JNI_OnLoad
+static struct {
+    jclass boolean_class;
+    jmethodID boolean_value_of;
+    jmethodID boolean_value;
+
+    jclass long_class;
+    jmethodID long_value_of;
+
+    jclass double_class;
+    jmethodID double_value_of;
+
+    jclass float_class;
+    jclass number_class;
+    jmethodID number_long_value;
+    jmethodID number_double_value;
+
+    jclass string_class;
+    jmethodID object_to_string;
+
+    jclass map_class;
+    jmethodID map_entry_set;
+    jclass map_entry_class;
+    jmethodID entry_get_key;
+    jmethodID entry_get_value;
+
+    jclass hash_map_class;
+    jmethodID hash_map_init;
+    jmethodID map_put;
+
+    jclass iterable_class;
+    jmethodID iterable_iterator;
+    jmethodID iterator_has_next;
+    jmethodID iterator_next;
+
+    jclass array_list_class;
+    jmethodID array_list_init;
+    jmethodID list_add;
+
+    jclass json_object_class;
+    jmethodID json_object_keys;
+    jmethodID json_object_opt;
+    jclass json_array_class;
+    jmethodID json_array_length;
+    jmethodID json_array_opt;
+    jobject json_null;
+} jt;
+
+static jclass global_class(JNIEnv *env, const char *name) {
+    jclass local = (*env)->FindClass(env, name);
+    if (!local) {
+        (*env)->ExceptionClear(env);
+        LOGE("❌ Class not found: %s", name);
+        return NULL;
+    }
+    jclass global = (jclass) (*env)->NewGlobalRef(env, local);
+    (*env)->DeleteLocalRef(env, local);
+    return global;
+}
+
+int nativephp_jni_init(JNIEnv *env) {
+    jt.boolean_class = global_class(env, "java/lang/Boolean");
+    jt.long_class = global_class(env, "java/lang/Long");
+    jt.double_class = global_class(env, "java/lang/Double");
+    jt.float_class = global_class(env, "java/lang/Float");
+    jt.number_class = global_class(env, "java/lang/Number");
+    jt.string_class = global_class(env, "java/lang/String");
+    jt.map_class = global_class(env, "java/util/Map");
+    jt.map_entry_class = global_class(env, "java/util/Map$Entry");
+    jt.hash_map_class = global_class(env, "java/util/HashMap");
+    jt.iterable_class = global_class(env, "java/lang/Iterable");
+    jt.array_list_class = global_class(env, "java/util/ArrayList");
+    jt.json_object_class = global_class(env, "org/json/JSONObject");
+    jt.json_array_class = global_class(env, "org/json/JSONArray");
+
+    if (!jt.boolean_class || !jt.long_class || !jt.double_class || !jt.float_class ||
+        !jt.number_class || !jt.string_class || !jt.map_class ||
+        !jt.map_entry_class || !jt.hash_map_class || !jt.iterable_class || !jt.array_list_class ||
+        !jt.json_object_class || !jt.json_array_class) {
+        return JNI_ERR;
+    }
+
+    jclass object_class = (*env)->FindClass(env, "java/lang/Object");
+    jclass iterator_class = (*env)->FindClass(env, "java/util/Iterator");
+
+    jt.boolean_value_of = (*env)->GetStaticMethodID(env, jt.boolean_class, "valueOf", "(Z)Ljava/lang/Boolean;");
+    jt.boolean_value = (*env)->GetMethodID(env, jt.boolean_class, "booleanValue", "()Z");
+    jt.long_value_of = (*env)->GetStaticMethodID(env, jt.long_class, "valueOf", "(J)Ljava/lang/Long;");
+    jt.double_value_of = (*env)->GetStaticMethodID(env, jt.double_class, "valueOf", "(D)Ljava/lang/Double;");
+    jt.number_long_value = (*env)->GetMethodID(env, jt.number_class, "longValue", "()J");
+    jt.number_double_value = (*env)->GetMethodID(env, jt.number_class, "doubleValue", "()D");
+    jt.object_to_string = (*env)->GetMethodID(env, object_class, "toString", "()Ljava/lang/String;");
+    jt.map_entry_set = (*env)->GetMethodID(env, jt.map_class, "entrySet", "()Ljava/util/Set;");
+    jt.entry_get_key = (*env)->GetMethodID(env, jt.map_entry_class, "getKey", "()Ljava/lang/Object;");
+    jt.entry_get_value = (*env)->GetMethodID(env, jt.map_entry_class, "getValue", "()Ljava/lang/Object;");
+    jt.hash_map_init = (*env)->GetMethodID(env, jt.hash_map_class, "<init>", "(I)V");
+    jt.map_put = (*env)->GetMethodID(env, jt.map_class, "put", "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+    jt.iterable_iterator = (*env)->GetMethodID(env, jt.iterable_class, "iterator", "()Ljava/util/Iterator;");
+    jt.iterator_has_next = (*env)->GetMethodID(env, iterator_class, "hasNext", "()Z");
+    jt.iterator_next = (*env)->GetMethodID(env, iterator_class, "next", "()Ljava/lang/Object;");
+    jt.array_list_init = (*env)->GetMethodID(env, jt.array_list_class, "<init>", "(I)V");
+    jt.list_add = (*env)->GetMethodID(env, jt.array_list_class, "add", "(Ljava/lang/Object;)Z");
+    jt.json_object_keys = (*env)->GetMethodID(env, jt.json_object_class, "keys", "()Ljava/util/Iterator;");
+    jt.json_object_opt = (*env)->GetMethodID(env, jt.json_object_class, "opt", "(Ljava/lang/String;)Ljava/lang/Object;");
+    jt.json_array_length = (*env)->GetMethodID(env, jt.json_array_class, "length", "()I");
+    jt.json_array_opt = (*env)->GetMethodID(env, jt.json_array_class, "opt", "(I)Ljava/lang/Object;");
+
+    jfieldID null_field = (*env)->GetStaticFieldID(env, jt.json_object_class, "NULL", "Ljava/lang/Object;");
+    jobject json_null = null_field ? (*env)->GetStaticObjectField(env, jt.json_object_class, null_field) : NULL;
+    jt.json_null = json_null ? (*env)->NewGlobalRef(env, json_null) : NULL;
+
+    (*env)->DeleteLocalRef(env, object_class);
+    (*env)->DeleteLocalRef(env, iterator_class);
+    if (json_null) (*env)->DeleteLocalRef(env, json_null);
+
+    if ((*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionClear(env);
+        LOGE("❌ Failed to resolve marshalling methods");
+        return JNI_ERR;
+    }
+    return JNI_OK;
+}
+
+// MARK: - zval -> Java
+
+static jstring php_string_to_java(JNIEnv *env, const char *value) {
+    jstring result = (*env)->NewStringUTF(env, value);
+    if (!result && (*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionClear(env);
+    }
+    return result;
+}
+
+static jobject zval_to_java(JNIEnv *env, zval *value, int depth);
+
+// Lists become ArrayList, everything else (or anything, with as_map) a HashMap
+static jobject hash_to_java(JNIEnv *env, HashTable *ht, int depth, int as_map) {
+    if (!as_map && zend_array_is_list(ht)) {
+        jobject list = (*env)->NewObject(env, jt.array_list_class, jt.array_list_init, (jint) zend_hash_num_elements(ht));
+        zval *item;
+        ZEND_HASH_FOREACH_VAL(ht, item) {
+            jobject jitem = zval_to_java(env, item, depth + 1);
+            (*env)->CallBooleanMethod(env, list, jt.list_add, jitem);
+            if (jitem) (*env)->DeleteLocalRef(env, jitem);
+        } ZEND_HASH_FOREACH_END();
+        return list;
+    }
+
+    jobject map = (*env)->NewObject(env, jt.hash_map_class, jt.hash_map_init, (jint) zend_hash_num_elements(ht));
+    zend_ulong index;
+    zend_string *key;
+    zval *item;
+    ZEND_HASH_FOREACH_KEY_VAL(ht, index, key, item) {
+        jstring jkey;
+        if (key) {
+            jkey = php_string_to_java(env, ZSTR_VAL(key));
+        } else {
+            char buf[MAX_LENGTH_OF_LONG + 1];
+            snprintf(buf, sizeof(buf), ZEND_ULONG_FMT, index);
+            jkey = php_string_to_java(env, buf);
+        }
+        jobject jitem = zval_to_java(env, item, depth + 1);
+        jobject previous = (*env)->CallObjectMethod(env, map, jt.map_put, jkey, jitem);
+        if (previous) (*env)->DeleteLocalRef(env, previous);
+        if (jkey) (*env)->DeleteLocalRef(env, jkey);
+        if (jitem) (*env)->DeleteLocalRef(env, jitem);
+    } ZEND_HASH_FOREACH_END();
+    return map;
+}
+
+static jobject zval_to_java(JNIEnv *env, zval *value, int depth) {
+    if (depth > MARSHAL_MAX_DEPTH) {
+        LOGE("⚠️ Nesting deeper than %d levels, passing null", MARSHAL_MAX_DEPTH);
+        return NULL;
+    }
+
+    ZVAL_DEREF(value);
+    switch (Z_TYPE_P(value)) {
+        case IS_FALSE:
+        case IS_TRUE:
+            return (*env)->CallStaticObjectMethod(env, jt.boolean_class, jt.boolean_value_of,
+                                                  (jboolean) (Z_TYPE_P(value) == IS_TRUE));
+        case IS_LONG:
+            return (*env)->CallStaticObjectMethod(env, jt.long_class, jt.long_value_of, (jlong) Z_LVAL_P(value));
+        case IS_DOUBLE:
+            return (*env)->CallStaticObjectMethod(env, jt.double_class, jt.double_value_of, (jdouble) Z_DVAL_P(value));
+        case IS_STRING:
+            return php_string_to_java(env, Z_STRVAL_P(value));
+        case IS_ARRAY:
+            return hash_to_java(env, Z_ARRVAL_P(value), depth, 0);
+        case IS_OBJECT: {
+            // Public properties, like a (array) cast
+            HashTable *props = zend_get_properties_for(value, ZEND_PROP_PURPOSE_ARRAY_CAST);
+            jobject result = props ? hash_to_java(env, props, depth, 0) : NULL;
+            if (props) zend_release_properties(props);
+            return result;
+        }
+        default:
+            return NULL;
+    }
+}
+
+// MARK: - Java -> zval
+
+static void java_to_zval(JNIEnv *env, jobject value, zval *out, int depth);
+
+static void java_string_to_zval(JNIEnv *env, jstring value, zval *out) {
+    const char *chars = (*env)->GetStringUTFChars(env, value, NULL);
+    if (!chars) {
+        (*env)->ExceptionClear(env);
+        ZVAL_NULL(out);
+        return;
+    }
+    ZVAL_STRING(out, chars);
+    (*env)->ReleaseStringUTFChars(env, value, chars);
+}
+
+static void java_map_to_zval(JNIEnv *env, jobject map, zval *out, int depth) {
+    array_init(out);
+
+    jobject entries = (*env)->CallObjectMethod(env, map, jt.map_entry_set);
+    jobject it = (*env)->CallObjectMethod(env, entries, jt.iterable_iterator);
+    while ((*env)->CallBooleanMethod(env, it, jt.iterator_has_next)) {
+        jobject entry = (*env)->CallObjectMethod(env, it, jt.iterator_next);
+        jobject jkey = (*env)->CallObjectMethod(env, entry, jt.entry_get_key);
+        jobject jvalue = (*env)->CallObjectMethod(env, entry, jt.entry_get_value);
+
+        jstring key_string = jkey ? (jstring) (*env)->CallObjectMethod(env, jkey, jt.object_to_string) : NULL;
+        if (key_string) {
+            const char *key = (*env)->GetStringUTFChars(env, key_string, NULL);
+            zval item;
+            java_to_zval(env, jvalue, &item, depth + 1);
+            zend_symtable_str_update(Z_ARRVAL_P(out), key, strlen(key), &item);
+            (*env)->ReleaseStringUTFChars(env, key_string, key);
+            (*env)->DeleteLocalRef(env, key_string);
+        }
+
+        if (jkey) (*env)->DeleteLocalRef(env, jkey);
+        if (jvalue) (*env)->DeleteLocalRef(env, jvalue);
+        (*env)->DeleteLocalRef(env, entry);
+    }
+    (*env)->DeleteLocalRef(env, it);
+    (*env)->DeleteLocalRef(env, entries);
+}
+
+static void java_iterable_to_zval(JNIEnv *env, jobject iterable, zval *out, int depth) {
+    array_init(out);
+
+    jobject it = (*env)->CallObjectMethod(env, iterable, jt.iterable_iterator);
+    while ((*env)->CallBooleanMethod(env, it, jt.iterator_has_next)) {
+        jobject jvalue = (*env)->CallObjectMethod(env, it, jt.iterator_next);
+        zval item;
+        java_to_zval(env, jvalue, &item, depth + 1);
+        add_next_index_zval(out, &item);
+        if (jvalue) (*env)->DeleteLocalRef(env, jvalue);
+    }
+    (*env)->DeleteLocalRef(env, it);
+}
+
+static void java_json_object_to_zval(JNIEnv *env, jobject object, zval *out, int depth) {
+    array_init(out);
+
+    jobject keys = (*env)->CallObjectMethod(env, object, jt.json_object_keys);
+    while ((*env)->CallBooleanMethod(env, keys, jt.iterator_has_next)) {
+        jstring jkey = (jstring) (*env)->CallObjectMethod(env, keys, jt.iterator_next);
+        jobject jvalue = (*env)->CallObjectMethod(env, object, jt.json_object_opt, jkey);
+
+        const char *key = (*env)->GetStringUTFChars(env, jkey, NULL);
+        zval item;
+        java_to_zval(env, jvalue, &item, depth + 1);
+        zend_symtable_str_update(Z_ARRVAL_P(out), key, strlen(key), &item);
+        (*env)->ReleaseStringUTFChars(env, jkey, key);
+
+        if (jvalue) (*env)->DeleteLocalRef(env, jvalue);
+        (*env)->DeleteLocalRef(env, jkey);
+    }
+    (*env)->DeleteLocalRef(env, keys);
+}
+
+static void java_json_array_to_zval(JNIEnv *env, jobject array, zval *out, int depth) {
+    jint length = (*env)->CallIntMethod(env, array, jt.json_array_length);
+    array_init_size(out, (uint32_t) length);
+
+    for (jint i = 0; i < length; i++) {
+        jobject jvalue = (*env)->CallObjectMethod(env, array, jt.json_array_opt, i);
+        zval item;
+        java_to_zval(env, jvalue, &item, depth + 1);
+        add_next_index_zval(out, &item);
+        if (jvalue) (*env)->DeleteLocalRef(env, jvalue);
+    }
+}
+
+static void java_to_zval(JNIEnv *env, jobject value, zval *out, int depth) {
+    if (!value || depth > MARSHAL_MAX_DEPTH || (jt.json_null && (*env)->IsSameObject(env, value, jt.json_null))) {
+        ZVAL_NULL(out);
+        return;
+    }
+
+    if ((*env)->IsInstanceOf(env, value, jt.string_class)) {
+        java_string_to_zval(env, (jstring) value, out);
+    } else if ((*env)->IsInstanceOf(env, value, jt.boolean_class)) {
+        ZVAL_BOOL(out, (*env)->CallBooleanMethod(env, value, jt.boolean_value));
+    } else if ((*env)->IsInstanceOf(env, value, jt.double_class) || (*env)->IsInstanceOf(env, value, jt.float_class)) {
+        ZVAL_DOUBLE(out, (*env)->CallDoubleMethod(env, value, jt.number_double_value));
+    } else if ((*env)->IsInstanceOf(env, value, jt.number_class)) {
+        ZVAL_LONG(out, (zend_long) (*env)->CallLongMethod(env, value, jt.number_long_value));
+    } else if ((*env)->IsInstanceOf(env, value, jt.map_class)) {
+        java_map_to_zval(env, value, out, depth);
+    } else if ((*env)->IsInstanceOf(env, value, jt.iterable_class)) {
+        java_iterable_to_zval(env, value, out, depth);
+    } else if ((*env)->IsInstanceOf(env, value, jt.json_object_class)) {
+        java_json_object_to_zval(env, value, out, depth);
+    } else if ((*env)->IsInstanceOf(env, value, jt.json_array_class)) {
+        java_json_array_to_zval(env, value, out, depth);
+    } else {
+        // Enums, CharSequences, anything else: its string form
+        jstring text = (jstring) (*env)->CallObjectMethod(env, value, jt.object_to_string);
+        if (text) {
+            java_string_to_zval(env, text, out);
+            (*env)->DeleteLocalRef(env, text);
+        } else {
+            ZVAL_NULL(out);
+        }
+    }
+
+    if ((*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionClear(env);
+        LOGE("❌ Java exception while converting bridge result");
+    }
+}
+
+// MARK: - PHP functions
+
+static void legacy_json_result(void *target, const char *data, size_t length) {
+    *(zend_string **) target = zend_string_init(data, length, 0);
+}
+
+/* {{{ Check whether a native bridge function is registered */
+PHP_FUNCTION(nativephp_can)
+{
+    zend_string *name;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_STR(name)
+    ZEND_PARSE_PARAMETERS_END();
+
+    RETURN_BOOL(NativePHPCan(ZSTR_VAL(name)));
+}
+/* }}} */
+
+/* {{{ Call a native bridge function.
+ * Array parameters are marshalled straight to a Java Map and the result comes
+ * back as a PHP array (null when the function is not registered). A string is
+ * taken as JSON-encoded parameters and the JSON result is returned as-is. */
+PHP_FUNCTION(nativephp_call)
+{
+    zend_string *name;
+    zval *params = NULL;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_STR(name)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ZVAL(params)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (params) {
+        ZVAL_DEREF(params);
+    }
+
+    if (params && Z_TYPE_P(params) == IS_STRING) {
+        zend_string *json = NULL;
+        NativePHPCall(ZSTR_VAL(name), Z_STRVAL_P(params), legacy_json_result, &json);
+        if (json) {
+            RETURN_STR(json);
+        }
+        RETURN_NULL();
+    }
+
+    if (params && Z_TYPE_P(params) != IS_ARRAY && Z_TYPE_P(params) != IS_NULL) {
+        zend_argument_type_error(2, "must be of type array|string|null, %s given", zend_zval_value_name(params));
+        RETURN_THROWS();
+    }
+
+    JNIEnv *env = NativeBridgeEnv();
+    if (!env || (*env)->PushLocalFrame(env, 32) != JNI_OK) {
+        RETURN_NULL();
+    }
+
+    // Bridge functions take a Map, so [] and lists are passed keyed by index
+    jobject jparams = (params && Z_TYPE_P(params) == IS_ARRAY)
+            ? hash_to_java(env, Z_ARRVAL_P(params), 0, 1)
+            : (*env)->NewObject(env, jt.hash_map_class, jt.hash_map_init, 0);
+
+    jobject result = NativePHPCallMap(env, ZSTR_VAL(name), jparams);
+    if (result) {
+        java_to_zval(env, result, return_value, 0);
+    } else {
+        RETVAL_NULL();
+    }
+
+    (*env)->PopLocalFrame(env, NULL);
+}
+/* }}} */
+
+/* {{{ Call several native bridge functions in order with one JNI transition.
+ * Each entry is ['name' => ..., 'params' => [...]]; returns one result per
+ * entry, null where the function is not registered. */
+PHP_FUNCTION(nativephp_call_many)
+{
+    HashTable *calls;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_ARRAY_HT(calls)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!zend_array_is_list(calls)) {
+        zend_argument_value_error(1, "must be a list of calls");
+        RETURN_THROWS();
+    }
+
+    if (zend_hash_num_elements(calls) == 0) {
+        RETURN_EMPTY_ARRAY();
+    }
+
+    JNIEnv *env = NativeBridgeEnv();
+    if (!env || (*env)->PushLocalFrame(env, 32) != JNI_OK) {
+        RETURN_NULL();
+    }
+
+    jobject jcalls = hash_to_java(env, calls, 0, 0);
+    jobject results = NativePHPCallMany(env, jcalls);
+    if (results) {
+        java_to_zval(env, results, return_value, 0);
+    } else {
+        RETVAL_NULL();
+    }
+
+    (*env)->PopLocalFrame(env, NULL);
+}
+/* }}} */
+
+/* {{{ Start a native bridge function on the bridge executor and return a
+ * ticket (0 when the function is not registered). Pair with nativephp_await()
+ * and nativephp_result(); Native::parallel() does this from Fibers. */
+PHP_FUNCTION(nativephp_call_async)
+{
+    zend_string *name;
+    HashTable *params = NULL;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_STR(name)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ARRAY_HT(params)
+    ZEND_PARSE_PARAMETERS_END();
+
+    JNIEnv *env = NativeBridgeEnv();
+    if (!env || (*env)->PushLocalFrame(env, 32) != JNI_OK) {
+        RETURN_LONG(0);
+    }
+
+    jobject jparams = params
+            ? hash_to_java(env, params, 0, 1)
+            : (*env)->NewObject(env, jt.hash_map_class, jt.hash_map_init, 0);
+    jlong ticket = NativePHPCallAsync(env, ZSTR_VAL(name), jparams);
+
+    (*env)->PopLocalFrame(env, NULL);
+    RETURN_LONG((zend_long) ticket);
+}
+/* }}} */
+
+/* {{{ Block until one of the given tickets has finished; returns that ticket,
+ * or null on timeout (timeout in milliseconds, negative waits forever). The
+ * wait never outlasts the request's watchdog deadline: the watchdog cannot
+ * stop a thread parked in Java, so a hung device call would otherwise hold
+ * the interpreter for good. */
+PHP_FUNCTION(nativephp_await)
+{
+    HashTable *tickets;
+    zend_long timeout = -1;
+
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ARRAY_HT(tickets)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(timeout)
+    ZEND_PARSE_PARAMETERS_END();
+
+    uint32_t count = zend_hash_num_elements(tickets);
+    if (count == 0) {
+        RETURN_NULL();
+    }
+
+    JNIEnv *env = NativeBridgeEnv();
+    if (!env) {
+        RETURN_NULL();
+    }
+
+    jlong *ids = safe_emalloc(count, sizeof(jlong), 0);
+    size_t n = 0;
+    zval *ticket;
+    ZEND_HASH_FOREACH_VAL(tickets, ticket) {
+        ids[n++] = (jlong) zval_get_long(ticket);
+    } ZEND_HASH_FOREACH_END();
+
+    int64_t remaining = bridge_watchdog_remaining_ms();
+    if (remaining >= 0 && (timeout < 0 || timeout > remaining)) {
+        timeout = (zend_long) remaining;
+    }
+
+    jlong done = NativePHPAwait(env, ids, n, (jlong) timeout);
+    efree(ids);
+
+    if (done == 0) {
+        RETURN_NULL();
+    }
+    RETURN_LONG((zend_long) done);
+}
+/* }}} */
+
+/* {{{ Collect the result of a finished async call */
+PHP_FUNCTION(nativephp_result)
+{
+    zend_long ticket;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(ticket)
+    ZEND_PARSE_PARAMETERS_END();
+
+    JNIEnv *env = NativeBridgeEnv();
+    if (!env || (*env)->PushLocalFrame(env, 32) != JNI_OK) {
+        RETURN_NULL();
+    }
+
+    jobject result = NativePHPResult(env, (jlong) ticket);
+    if (result) {
+        java_to_zval(env, result, return_value, 0);
+    } else {
+        RETVAL_NULL();
+    }
+
+    (*env)->PopLocalFrame(env, NULL);
+}
+/* }}} */
+
+/* {{{ Move the running request's deadline to $milliseconds from now (0 = no limit) */
+PHP_FUNCTION(nativephp_deadline)
+{
+    zend_long milliseconds;
+
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(milliseconds)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (milliseconds < 0) {
+        zend_argument_value_error(1, "must be greater than or equal to 0");
+        RETURN_THROWS();
+    }
+
+    RETURN_BOOL(bridge_watchdog_extend((uint64_t) milliseconds));
+}
+/* }}} */
+
+/* {{{ Timing and memory of the most recent bridge requests, oldest first */
+PHP_FUNCTION(nativephp_metrics)
+{
+    zend_long limit = 0;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG(limit)
+    ZEND_PARSE_PARAMETERS_END();
+
+    bridge_metrics *items = safe_emalloc(BRIDGE_METRICS_RING, sizeof(bridge_metrics), 0);
+    size_t count = bridge_metrics_snapshot(items, BRIDGE_METRICS_RING);
+    size_t first = (limit > 0 && (size_t) limit < count) ? count - (size_t) limit : 0;
+
+    array_init_size(return_value, (uint32_t) (count - first));
+    for (size_t i = first; i < count; i++) {
+        bridge_metrics *m = &items[i];
+        zval entry;
+        char key[32];
+
+        array_init_size(&entry, 16);
+        add_assoc_long(&entry, "id", (zend_long) m->id);
+        add_assoc_double(&entry, "time", (double) m->started_at_ms / 1000.0);
+        add_assoc_string(&entry, "method", m->method);
+        add_assoc_string(&entry, "uri", m->uri);
+        add_assoc_long(&entry, "status", m->status);
+        add_assoc_bool(&entry, "worker", m->worker);
+        for (int p = 0; p < BRIDGE_PHASE_COUNT; p++) {
+            snprintf(key, sizeof(key), "%s_ms", bridge_phase_name((bridge_phase) p));
+            add_assoc_double(&entry, key, (double) m->phase_ns[p] / 1000000.0);
+        }
+        add_assoc_double(&entry, "total_ms", (double) m->total_ns / 1000000.0);
+        add_assoc_long(&entry, "peak_memory", (zend_long) m->peak_memory);
+        add_assoc_long(&entry, "heap_size", (zend_long) m->heap_size);
+        add_assoc_long(&entry, "bytes_out", (zend_long) m->bytes_out);
+        add_next_index_zval(return_value, &entry);
+    }
+
+    efree(items);
+}
+/* }}} */
+
+/* {{{ Drop cached responses carrying any of $tags, or all of them when $tags is null */
+PHP_FUNCTION(nativephp_cache_forget)
+{
+    HashTable *tags = NULL;
+
+    ZEND_PARSE_PARAMETERS_START(0, 1)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ARRAY_HT_OR_NULL(tags)
+    ZEND_PARSE_PARAMETERS_END();
+
+    if (!tags) {
+        RETURN_LONG((zend_long) bridge_cache_forget(NULL, 0));
+    }
+
+    uint32_t count = zend_hash_num_elements(tags);
+    const char **names = safe_emalloc(count ? count : 1, sizeof(char *), 0);
+    size_t used = 0;
+    zval *tag;
+    ZEND_HASH_FOREACH_VAL(tags, tag) {
+        if (Z_TYPE_P(tag) == IS_STRING) {
+            names[used++] = Z_STRVAL_P(tag);
+        }
+    } ZEND_HASH_FOREACH_END();
+
+    zend_long removed = used ? (zend_long) bridge_cache_forget(names, used) : 0;
+    efree(names);
+    RETURN_LONG(removed);
+}
+/* }}} */
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_nativephp_can, 0, 1, _IS_BOOL, 0)
+    ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_nativephp_call, 0, 1, IS_MIXED, 0)
+    ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+    ZEND_ARG_TYPE_MASK(0, parameters, MAY_BE_ARRAY|MAY_BE_STRING|MAY_BE_NULL, "null")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_nativephp_call_many, 0, 1, IS_ARRAY, 1)
+    ZEND_ARG_TYPE_INFO(0, calls, IS_ARRAY, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_nativephp_call_async, 0, 1, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO(0, name, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, parameters, IS_ARRAY, 0, "[]")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_nativephp_await, 0, 1, IS_LONG, 1)
+    ZEND_ARG_TYPE_INFO(0, tickets, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, timeout, IS_LONG, 0, "-1")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_nativephp_result, 0, 1, IS_ARRAY, 1)
+    ZEND_ARG_TYPE_INFO(0, ticket, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_nativephp_deadline, 0, 1, _IS_BOOL, 0)
+    ZEND_ARG_TYPE_INFO(0, milliseconds, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_nativephp_metrics, 0, 0, IS_ARRAY, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, limit, IS_LONG, 0, "0")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_WITH_RETURN_TYPE_INFO_EX(arginfo_nativephp_cache_forget, 0, 0, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, tags, IS_ARRAY, 1, "null")
+ZEND_END_ARG_INFO()
+
+static const zend_function_entry nativephp_functions[] = {
+    PHP_FE(nativephp_can, arginfo_nativephp_can)
+    PHP_FE(nativephp_call, arginfo_nativephp_call)
+    PHP_FE(nativephp_call_many, arginfo_nativephp_call_many)
+    PHP_FE(nativephp_call_async, arginfo_nativephp_call_async)
+    PHP_FE(nativephp_await, arginfo_nativephp_await)
+    PHP_FE(nativephp_result, arginfo_nativephp_result)
+    PHP_FE(nativephp_deadline, arginfo_nativephp_deadline)
+    PHP_FE(nativephp_metrics, arginfo_nativephp_metrics)
+    PHP_FE(nativephp_cache_forget, arginfo_nativephp_cache_forget)
+    PHP_FE_END
+};
+
+// The persistent $_SERVER template (PHP.c) needs permanent interned strings
+// and the profiler's observer must register, both of which only module startup
+// may do; the metrics compile hooks, the sampler's interrupt hook and the
+// request watchdog thread live as long as the engine, and so do cached responses
+static PHP_MINIT_FUNCTION(nativephp)
+{
+    android_server_template_startup();
+    bridge_metrics_startup();
+    bridge_profiler_startup();
+    bridge_sampler_startup();
+    bridge_watchdog_startup();
+    bridge_cache_startup();
+    return SUCCESS;
+}
+
+static PHP_MSHUTDOWN_FUNCTION(nativephp)
+{
+    bridge_cache_shutdown();
+    bridge_watchdog_shutdown();
+    bridge_sampler_shutdown();
+    bridge_metrics_shutdown();
+    android_server_template_shutdown();
+    return SUCCESS;
+}
+
+zend_module_entry nativephp_module_entry = {
+    STANDARD_MODULE_HEADER,
+    "nativephp",
+    nativephp_functions,
+    PHP_MINIT(nativephp),
+    PHP_MSHUTDOWN(nativephp),
+    NULL,   // RINIT
+    NULL,   // RSHUTDOWN
+    NULL,   // MINFO
+    "1.0",
+    STANDARD_MODULE_PROPERTIES
+};
@@ -3,6 +3,14 @@
 #include "php_embed.h"
 #include "PHP.h"
 #include <zend_exceptions.h>
+#include <php_variables.h>
+#include <ext/standard/basic_functions.h>
+#include <http_status_codes.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Define Android logging macros first
 #define LOG_TAG "PHP-Native"
@@ -19,9 +27,167 @@ extern jint InitializeBridgeJNI(JNIEnv* env);
 static int php_initialized = 0;
 static jobject g_callback_obj = NULL;
 static jmethodID g_callback_method = NULL;
-static char *g_collected_output = NULL;
-static size_t g_collected_length = 0;
-static size_t g_collected_capacity = 0;
+
+// Interpreter pool
+// With a ZTS libphp every Kotlin pool thread owns one interpreter (its own TSRM
+// resources + bridge_request_ctx). Engine startup/shutdown take the engine lock
+// exclusively, requests take it shared. An NTS libphp only has one interpreter,
+// so the pool is clamped to a single thread and the lock is a plain mutex: it
+// still serializes the entry points that run PHP off the pool thread (runner
+// commands, nativeExecuteScript) and nativeSetEnv against the request in flight.
+#define MAX_INTERPRETERS 4
+
+static unsigned int g_engine_generation = 1;
+
+// Current onTrimMemory round and whether it asked for a full trim
+static unsigned int g_trim_round = 0;
+static int g_trim_full = 0;
+
+#ifdef ZTS
+static __thread bridge_request_ctx t_request_ctx;
+static pthread_rwlock_t g_engine_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+#define ENGINE_LOCK_SHARED()    pthread_rwlock_rdlock(&g_engine_lock)
+#define ENGINE_LOCK_EXCLUSIVE() pthread_rwlock_wrlock(&g_engine_lock)
+#define ENGINE_UNLOCK()         pthread_rwlock_unlock(&g_engine_lock)
+#else
+static bridge_request_ctx g_request_ctx;
+static pthread_mutex_t g_engine_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define ENGINE_LOCK_SHARED()    pthread_mutex_lock(&g_engine_lock)
+#define ENGINE_LOCK_EXCLUSIVE() pthread_mutex_lock(&g_engine_lock)
+#define ENGINE_UNLOCK()         pthread_mutex_unlock(&g_engine_lock)
+#endif
+
+bridge_request_ctx *bridge_ctx(void) {
+#ifdef ZTS
+    return &t_request_ctx;
+#else
+    return &g_request_ctx;
+#endif
+}
+
+int bridge_max_interpreters(void) {
+#ifdef ZTS
+    return MAX_INTERPRETERS;
+#else
+    return 1;
+#endif
+}
+
+#ifdef ZTS
+static void worker_stop();
+
+static pthread_key_t g_interpreter_key;
+static pthread_once_t g_interpreter_key_once = PTHREAD_ONCE_INIT;
+
+// Runs when a pool thread exits: stop its worker on this thread and give its
+// TSRM resources back. After an engine shutdown TSRM is gone, so there is
+// nothing to free; the thread that started TSRM keeps its resources for
+// module shutdown.
+static void interpreter_thread_exit(void *unused) {
+    bridge_request_ctx *ctx = bridge_ctx();
+
+    ENGINE_LOCK_SHARED();
+    if (php_initialized && ctx->thread_attached && ctx->engine_generation == g_engine_generation) {
+        worker_stop();
+        if (!tsrm_is_main_thread()) {
+            ts_free_thread();
+        }
+        LOGI("🧵 Interpreter released by thread %ld", (long) pthread_self());
+    }
+    ctx->thread_attached = 0;
+    ENGINE_UNLOCK();
+}
+
+static void create_interpreter_key() {
+    pthread_key_create(&g_interpreter_key, interpreter_thread_exit);
+}
+
+// Engine owner thread
+// tsrm_shutdown() only works on the thread that ran tsrm_startup(), and that
+// thread's resources must outlive every interpreter. Engine start and shutdown
+// therefore run on a thread of their own that never serves requests.
+static pthread_once_t g_owner_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t g_owner_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_owner_cond = PTHREAD_COND_INITIALIZER;
+static int (*g_owner_task)(void) = NULL;
+static int g_owner_result = 0;
+
+static void *engine_owner_main(void *unused) {
+    pthread_mutex_lock(&g_owner_lock);
+    for (;;) {
+        while (!g_owner_task) pthread_cond_wait(&g_owner_cond, &g_owner_lock);
+
+        int (*task)(void) = g_owner_task;
+        pthread_mutex_unlock(&g_owner_lock);
+        int result = task();
+        pthread_mutex_lock(&g_owner_lock);
+
+        g_owner_result = result;
+        g_owner_task = NULL;
+        pthread_cond_broadcast(&g_owner_cond);
+    }
+    return NULL;
+}
+
+static void create_engine_owner() {
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, engine_owner_main, NULL) != 0) {
+        LOGE("❌ Could not start the engine owner thread");
+    }
+    pthread_attr_destroy(&attr);
+}
+
+// Run task on the engine owner thread and return its result. Callers hold the
+// engine lock exclusively, so only one task is ever in flight.
+static int engine_owner_run(int (*task)(void)) {
+    pthread_once(&g_owner_once, create_engine_owner);
+
+    pthread_mutex_lock(&g_owner_lock);
+    g_owner_task = task;
+    pthread_cond_broadcast(&g_owner_cond);
+    while (g_owner_task) pthread_cond_wait(&g_owner_cond, &g_owner_lock);
+    int result = g_owner_result;
+    pthread_mutex_unlock(&g_owner_lock);
+    return result;
+}
+#else
+// One interpreter and no TSRM: any thread may start and stop the engine
+#define engine_owner_run(task) (task)()
+#endif
+
+// Bind the calling thread to an interpreter. Worker state left over from a
+// previous engine instance (runner command, shutdown) is forgotten, because the
+// engine that owned it is gone.
+static void bridge_thread_attach() {
+    bridge_request_ctx *ctx = bridge_ctx();
+
+    if (ctx->engine_generation != g_engine_generation) {
+        ctx->worker_booted = 0;
+        ZVAL_UNDEF(&ctx->worker_handler);
+        ctx->stdout_stream = NULL;
+        ctx->thread_attached = 0;
+        ctx->sampler_slot = 0;
+        ctx->watchdog_slot = 0;
+        ctx->trim_round = __atomic_load_n(&g_trim_round, __ATOMIC_ACQUIRE);
+        ctx->engine_generation = g_engine_generation;
+    }
+
+#ifdef ZTS
+    if (!ctx->thread_attached) {
+        ts_resource(0);
+        ZEND_TSRMLS_CACHE_UPDATE();
+        pthread_once(&g_interpreter_key_once, create_interpreter_key);
+        pthread_setspecific(g_interpreter_key, ctx);
+        LOGI("🧵 Interpreter attached to thread %ld", (long) pthread_self());
+    }
+#endif
+    ctx->thread_attached = 1;
+}
 
 #define BUFFER_CHUNK_SIZE (256 * 1024)  // 256KB increments
 #define MAX_BUFFER_SIZE (16 * 1024 * 1024)  // 16MB max buffer
@@ -29,37 +195,45 @@ static size_t g_collected_capacity = 0;
 static void (*jni_output_callback_ptr)(const char *) = NULL;
 
 void clear_collected_output() {
-    if (g_collected_output) {
-        free(g_collected_output);
-        g_collected_output = NULL;
+    bridge_request_ctx *ctx = bridge_ctx();
+
+    // A baseline buffer is reused; one that grew for a large response is replaced
+    if (ctx->output && ctx->output_capacity == BUFFER_CHUNK_SIZE) {
+        ctx->output_length = 0;
+        ctx->output[0] = '\0';
+        return;
+    }
+    if (ctx->output) {
+        free(ctx->output);
+        ctx->output = NULL;
     }
 
-    g_collected_capacity = BUFFER_CHUNK_SIZE;
-    g_collected_length = 0;
-    g_collected_output = (char *) malloc(g_collected_capacity);
-    if (g_collected_output) {
-        g_collected_output[0] = '\0';
+    ctx->output_capacity = BUFFER_CHUNK_SIZE;
+    ctx->output_length = 0;
+    ctx->output = (char *) malloc(ctx->output_capacity);
+    if (ctx->output) {
+        ctx->output[0] = '\0';
     }
 }
 
 
-void pipe_php_output(const char *str) {
-
-//    LOGI("PIPE: Output received: %s", str);
+// Append raw bytes to the output buffer. Length-tracked, so NUL bytes in
+// images or binary downloads survive; a trailing NUL is kept only for callers
+// that read the buffer as a C string (runner output).
+static void append_php_output(const char *str, size_t length) {
+    bridge_request_ctx *ctx = bridge_ctx();
 
     // Safety check
-    if (!g_collected_output) {
+    if (!ctx->output) {
         clear_collected_output();
-        return;  // Failed to allocate
+        if (!ctx->output) return;  // Failed to allocate
     }
 
-    size_t length = strlen(str);
-
     // Check if we need more space
-    if (g_collected_length + length + 1 > g_collected_capacity) {
+    if (ctx->output_length + length + 1 > ctx->output_capacity) {
         // Calculate new size in chunks
-        size_t needed_capacity = g_collected_capacity;
-        while (needed_capacity < g_collected_length + length + 1) {
+        size_t needed_capacity = ctx->output_capacity;
+        while (needed_capacity < ctx->output_length + length + 1) {
             needed_capacity += BUFFER_CHUNK_SIZE;
         }
 
@@ -71,50 +245,45 @@ void pipe_php_output(const char *str) {
         }
 
         // Reallocate with the new size
-        char *new_buffer = (char *) realloc(g_collected_output, needed_capacity);
+        char *new_buffer = (char *) realloc(ctx->output, needed_capacity);
         if (new_buffer) {
-            g_collected_output = new_buffer;
-            g_collected_capacity = needed_capacity;
+            ctx->output = new_buffer;
+            ctx->output_capacity = needed_capacity;
         } else {
             LOGE("Failed to reallocate output buffer to %zu bytes", needed_capacity);
             return;  // Failed to reallocate
         }
     }
 
-    // Append the string
-    strcpy(g_collected_output + g_collected_length, str);
-    g_collected_length += length;
+    memcpy(ctx->output + ctx->output_length, str, length);
+    ctx->output_length += length;
+    ctx->output[ctx->output_length] = '\0';
+}
+
+void pipe_php_output(const char *str) {
+    append_php_output(str, strlen(str));
 }
 
 void cleanup_output_buffer() {
-    if (g_collected_output) {
-        g_collected_output[0] = '\0';
-        g_collected_length = 0;
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (ctx->output) {
+        ctx->output[0] = '\0';
+        ctx->output_length = 0;
     }
 }
 
-size_t capture_php_output(const char *str, size_t str_length) {
-    // Log the raw output coming from PHP
-//    LOGI("PHP output captured: length=%zu", str_length);
-    if (str_length > 0) {
-        // Log a preview of the output (first 100 chars or so)
-        char preview[10001] = {0};
-        strncpy(preview, str, str_length > 10000 ? 10000 : str_length);
-        preview[10000] = '\0'; // Ensure null termination
-    } else {
-        LOGI("Empty output received");
-    }
+static void stream_write(const char *data, size_t length);
 
-    // Rest of your original code...
-    char *buffer = malloc(str_length + 1);
-    if (buffer) {
-        memcpy(buffer, str, str_length);
-        buffer[str_length] = '\0';
+size_t capture_php_output(const char *str, size_t str_length) {
+    if (str_length == 0) return 0;
 
-        pipe_php_output(buffer);
-        free(buffer);
+    uint64_t start = bridge_now_ns();
+    if (bridge_ctx()->streaming) {
+        stream_write(str, str_length);
+    } else {
+        append_php_output(str, str_length);
     }
-
+    bridge_metrics_output(str_length, start);
     return str_length;
 }
 
@@ -133,7 +302,6 @@ void jni_output_callback(const char *output) {
     }
 
     if (g_callback_obj && g_callback_method) {
-        LOGI("WE MADE IT HERE");
         jstring joutput = (*env)->NewStringUTF(env, output);
         (*env)->CallVoidMethod(env, g_callback_obj, g_callback_method, joutput);
         (*env)->DeleteLocalRef(env, joutput);
@@ -141,168 +309,578 @@ void jni_output_callback(const char *output) {
 
 }
 
-// Header collection buffer
-static char *g_header_buffer = NULL;
-static size_t g_header_length = 0;
-static size_t g_header_capacity = 0;
-static char g_status_line[128] = {0};
+
+#define HEADER_BUFFER_SIZE 4096
 
 static void clear_header_buffer() {
-    if (g_header_buffer) {
-        free(g_header_buffer);
-        g_header_buffer = NULL;
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!ctx->headers) {
+        ctx->header_capacity = HEADER_BUFFER_SIZE;
+        ctx->headers = (char *) malloc(ctx->header_capacity);
     }
-    g_header_capacity = BUFFER_CHUNK_SIZE;
-    g_header_length = 0;
-    g_header_buffer = (char *) malloc(g_header_capacity);
-    if (g_header_buffer) {
-        g_header_buffer[0] = '\0';
+    ctx->header_length = 0;
+    ctx->header_count = 0;
+    ctx->status_code = 200;
+    bridge_sendfile_reset();
+    bridge_cache_directive_reset();
+}
+
+// Append one "name\0value\0" pair to the response head
+static void append_header(const char *name, size_t name_length, const char *value, size_t value_length) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    size_t needed = ctx->header_length + name_length + value_length + 2;
+    if (needed > ctx->header_capacity) {
+        size_t capacity = ctx->header_capacity ? ctx->header_capacity : HEADER_BUFFER_SIZE;
+        while (capacity < needed) capacity *= 2;
+        char *newbuf = (char *) realloc(ctx->headers, capacity);
+        if (!newbuf) return;
+        ctx->headers = newbuf;
+        ctx->header_capacity = capacity;
     }
-    g_status_line[0] = '\0';
+    memcpy(ctx->headers + ctx->header_length, name, name_length);
+    ctx->header_length += name_length;
+    ctx->headers[ctx->header_length++] = '\0';
+    memcpy(ctx->headers + ctx->header_length, value, value_length);
+    ctx->header_length += value_length;
+    ctx->headers[ctx->header_length++] = '\0';
+    ctx->header_count++;
 }
 
-static void append_header_line(const char *line) {
-    size_t length = strlen(line);
-    if (g_header_length + length + 3 > g_header_capacity) {
-        size_t needed = g_header_capacity;
-        while (needed < g_header_length + length + 3) {
-            needed += BUFFER_CHUNK_SIZE;
+// Once a response has been handed to Kotlin, give back what a large one made
+// the output and header buffers grow to; the next request starts at baseline
+static void shrink_response_buffers() {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (ctx->output && ctx->output_capacity > BUFFER_CHUNK_SIZE) {
+        free(ctx->output);
+        ctx->output = NULL;
+        ctx->output_length = 0;
+        ctx->output_capacity = 0;
+    }
+    if (ctx->headers && ctx->header_capacity > HEADER_BUFFER_SIZE) {
+        char *smaller = (char *) realloc(ctx->headers, HEADER_BUFFER_SIZE);
+        if (smaller) {
+            ctx->headers = smaller;
+            ctx->header_capacity = HEADER_BUFFER_SIZE;
+            ctx->header_length = 0;
+            ctx->header_count = 0;
         }
-        char *newbuf = (char *) realloc(g_header_buffer, needed);
-        if (!newbuf) return;
-        g_header_buffer = newbuf;
-        g_header_capacity = needed;
-    }
-    strcpy(g_header_buffer + g_header_length, line);
-    g_header_length += length;
-    g_header_buffer[g_header_length++] = '\r';
-    g_header_buffer[g_header_length++] = '\n';
-    g_header_buffer[g_header_length] = '\0';
-}
-
-int android_header_handler(sapi_header_struct *sapi_header, sapi_header_op_enum op, sapi_headers_struct *sapi_headers) {
-    LOGI("📤 SAPI header: %s", sapi_header->header);
-    if (!sapi_header || !sapi_header->header) return 0;
-    const char *h = sapi_header->header;
-    if (strncmp(h, "HTTP/", 5) == 0) {
-        strncpy(g_status_line, h, sizeof(g_status_line) - 1);
-        g_status_line[sizeof(g_status_line) - 1] = '\0';
-        return 0;
     }
-    append_header_line(h);
-    return 0;
 }
 
-char* run_php_script_once(const char* scriptPath, const char* method, const char* uri, const char* postData, const char* content_type) {
+// Bridge-generated responses (engine failure, malformed request)
+static void set_error_response(int code, const char *message) {
+    bridge_sendfile_reset();
     clear_collected_output();
     clear_header_buffer();
+    bridge_ctx()->status_code = code;
+    append_header("Content-Type", sizeof("Content-Type") - 1, "text/plain", sizeof("text/plain") - 1);
+    pipe_php_output(message);
+}
 
-    // 🧠 Get session path from environment (set by Kotlin)
-    const char* session_path = getenv("SESSION_SAVE_PATH");
-    if (!session_path) session_path = "/tmp"; // fallback
+// The watchdog stopped a request that ran past its deadline. A streamed
+// response whose head already went out just ends where PHP stopped.
+static void set_timeout_response(uint64_t elapsed_ms) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    LOGE("⏰ Request %s aborted after %llums", ctx->metrics.uri, (unsigned long long) elapsed_ms);
+    if (ctx->streaming && ctx->stream_head_sent) return;
+
+    char message[160];
+    snprintf(message, sizeof(message), "Request timed out: %s %s was stopped after %llu ms.",
+             ctx->metrics.method, ctx->metrics.uri, (unsigned long long) elapsed_ms);
+    set_error_response(503, message);
+    append_header("Retry-After", sizeof("Retry-After") - 1, "1", 1);
+}
 
-    // ✅ Build ini entries per request
-    php_embed_module.ub_write = capture_php_output;
-    php_embed_module.phpinfo_as_text = 1;
-    php_embed_module.php_ini_ignore = 0;
-    php_embed_module.header_handler = android_header_handler;
+// Split each final "Name: value" SAPI header into the context's header pairs;
+// X-Sendfile (file response) and X-Bridge-Cache (response cache) are kept back
+static void capture_sapi_headers(sapi_headers_struct *sapi_headers) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    ctx->header_length = 0;
+    ctx->header_count = 0;
+    ctx->status_code = sapi_headers->http_response_code ? sapi_headers->http_response_code : 200;
+    bridge_sendfile_reset();
+    bridge_cache_directive_reset();
+
+    zend_llist_position pos;
+    sapi_header_struct *h = (sapi_header_struct *) zend_llist_get_first_ex(&sapi_headers->headers, &pos);
+    while (h) {
+        const char *colon = memchr(h->header, ':', h->header_len);
+        if (colon && colon > h->header) {
+            const char *value = colon + 1;
+            const char *end = h->header + h->header_len;
+            while (value < end && (*value == ' ' || *value == '\t')) value++;
+            size_t name_length = (size_t) (colon - h->header);
+            if (!bridge_sendfile_header(h->header, name_length, value, (size_t) (end - value)) &&
+                !bridge_cache_header(h->header, name_length, value, (size_t) (end - value))) {
+                append_header(h->header, name_length, value, (size_t) (end - value));
+            }
+        }
+        h = (sapi_header_struct *) zend_llist_get_next_ex(&sapi_headers->headers, &pos);
+    }
+    bridge_sendfile_resolve();
+}
 
-    sapi_module.header_handler = android_header_handler;
-    if (!php_initialized) {
-        if (php_embed_init(0, NULL) != SUCCESS) {
-            return strdup("HTTP/1.1 500 Internal Server Error\r\nContent-Type: text/plain\r\n\r\nPHP init failed.");
+static const char *status_text(int code) {
+    for (size_t i = 0; i < http_status_map_len; i++) {
+        if (http_status_map[i].code == code) return http_status_map[i].str;
+    }
+    return "Unknown";
+}
+
+// Streaming output
+// In streaming mode the head (status + headers) is passed to the Kotlin sink as
+// soon as PHP sends headers, and every ub_write chunk is written to a pipe whose
+// read end backs the WebResourceResponse, so nothing is buffered or capped here.
+
+static jobjectArray header_array(JNIEnv *env, int values);
+static jobject build_response(JNIEnv *env, int with_body);
+
+// Hand the response head to PHPBridge.StreamSink.onHead(PHPResponse)
+static void stream_send_head() {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!ctx->streaming || ctx->stream_head_sent) return;
+    ctx->stream_head_sent = 1;
+
+    JNIEnv *env = ctx->stream_env;
+    jobject head = build_response(env, 0);
+    if (!head) return;
+
+    jclass sinkClass = (*env)->GetObjectClass(env, ctx->stream_sink);
+    jmethodID onHead = (*env)->GetMethodID(env, sinkClass, "onHead", "(Lcom/fuse/php/bridge/PHPResponse;)V");
+    if (onHead) {
+        (*env)->CallVoidMethod(env, ctx->stream_sink, onHead, head);
+        if ((*env)->ExceptionCheck(env)) {
+            LOGE("❌ StreamSink.onHead threw");
+            (*env)->ExceptionClear(env);
+        }
+    }
+    (*env)->DeleteLocalRef(env, sinkClass);
+    (*env)->DeleteLocalRef(env, head);
+    LOGI("📤 Streamed response head: %d", ctx->status_code);
+}
+
+static void stream_write(const char *data, size_t length) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!ctx->stream_head_sent) stream_send_head();
+    // A response headed for the cache also keeps a copy of its body
+    if (ctx->cache_directive && data != ctx->output) append_php_output(data, length);
+    if (ctx->stream_fd < 0) return;
+
+    while (length > 0) {
+        ssize_t written = write(ctx->stream_fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            // Reader went away (WebView cancelled, redirect intercepted); drop the rest
+            LOGI("⚠️ Response stream closed by reader (%s)", strerror(errno));
+            close(ctx->stream_fd);
+            ctx->stream_fd = -1;
+            return;
+        }
+        data += written;
+        length -= (size_t) written;
+    }
+}
+
+static void stream_begin(JNIEnv *env, int fd, jobject sink) {
+    bridge_request_ctx *ctx = bridge_ctx();
+
+    // A closed read end must surface as EPIPE, not kill the process
+    sigset_t pipe_mask;
+    sigemptyset(&pipe_mask);
+    sigaddset(&pipe_mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_mask, NULL);
+
+    ctx->streaming = 1;
+    ctx->stream_fd = fd;
+    ctx->stream_head_sent = 0;
+    ctx->stream_env = env;
+    ctx->stream_sink = sink;
+}
+
+// Make sure the head went out (no output, fatal before headers) and close the pipe
+static void stream_finish() {
+    bridge_request_ctx *ctx = bridge_ctx();
+
+    // Buffered output goes out only if PHP never streamed: an engine failure or
+    // a cache hit. Otherwise it is the copy kept for the response cache.
+    int buffered = !ctx->stream_head_sent;
+    stream_send_head();
+    if (buffered && ctx->output && ctx->output_length > 0) {
+        stream_write(ctx->output, ctx->output_length);
+    }
+    // X-Sendfile: the file goes down the pipe after whatever PHP printed
+    bridge_sendfile_pipe(ctx->stream_fd);
+    if (ctx->stream_fd >= 0) {
+        close(ctx->stream_fd);
+    }
+
+    ctx->streaming = 0;
+    ctx->stream_fd = -1;
+    ctx->stream_env = NULL;
+    ctx->stream_sink = NULL;
+}
+
+// Server-Timing from the request's metrics; a streamed head only knows the
+// phases that ran before PHP sent headers
+static void append_server_timing(int final) {
+    char timing[256];
+    size_t length = bridge_metrics_server_timing(&bridge_ctx()->metrics, final, timing, sizeof(timing));
+    append_header("Server-Timing", sizeof("Server-Timing") - 1, timing, length);
+}
+
+// send_headers: capture the final status and header list, then release the head in streaming mode
+static int bridge_send_headers(sapi_headers_struct *sapi_headers) {
+    capture_sapi_headers(sapi_headers);
+
+    if (bridge_ctx()->streaming) {
+        append_server_timing(0);
+        stream_send_head();
+    }
+    return SAPI_HEADER_SENT_SUCCESSFULLY;
+}
+
+// Worker mode state
+// mobile_boot.php boots the framework once and leaves a request handler in
+// $GLOBALS['__mobile_worker']. Later requests are fed to that handler inside
+// the same long-lived PHP request, so Bootstrap, config, routes and the class
+// table survive between requests. Superglobals and output are reset per request.
+#define WORKER_HANDLER_GLOBAL "__mobile_worker"
+
+
+static int worker_mode_enabled() {
+    const char *flag = getenv("MVC_WORKER_MODE");
+    return flag && (strcmp(flag, "1") == 0 || strcasecmp(flag, "true") == 0);
+}
+
+// Grab the handler registered by mobile_boot.php after the boot request ran
+static int worker_capture_handler() {
+    bridge_request_ctx *ctx = bridge_ctx();
+    zval *handler = zend_hash_str_find(&EG(symbol_table), WORKER_HANDLER_GLOBAL, sizeof(WORKER_HANDLER_GLOBAL) - 1);
+    if (!handler) {
+        LOGI("⚠️ Worker mode enabled but no $%s handler registered", WORKER_HANDLER_GLOBAL);
+        return 0;
+    }
+    ZVAL_DEREF(handler);
+    if (!zend_is_callable(handler, 0, NULL)) {
+        LOGE("❌ $%s is not callable, falling back to per-request boot", WORKER_HANDLER_GLOBAL);
+        return 0;
+    }
+    ZVAL_COPY(&ctx->worker_handler, handler);
+    return 1;
+}
+
+// Reset the session module so the next session_start() reads the new cookie
+// instead of reusing the previous request's session id
+static void worker_reset_session() {
+    zend_module_entry *session = zend_hash_str_find_ptr(&module_registry, "session", sizeof("session") - 1);
+    if (!session) return;
+
+    zend_try {
+        if (session->request_shutdown_func) {
+            session->request_shutdown_func(session->type, session->module_number);
+        }
+        if (session->request_startup_func) {
+            session->request_startup_func(session->type, session->module_number);
+        }
+    } zend_end_try();
+}
+
+static void worker_clear_request_info() {
+    SG(request_info).request_method = NULL;
+    SG(request_info).request_uri = NULL;
+    SG(request_info).query_string = NULL;
+    SG(request_info).cookie_data = NULL;
+    SG(request_info).content_type = NULL;
+    SG(request_info).content_length = 0;
+    SG(server_context) = NULL;
+    bridge_ctx()->request = NULL;
+}
+
+// Re-arm SAPI, output layer and superglobals for the next request
+static int worker_request_startup(bridge_request *req) {
+    int ok = 1;
+
+    uint64_t t = bridge_now_ns();
+    prime_request_info(req);
+
+    zend_try {
+        php_output_activate();
+        PG(header_is_being_sent) = 0;
+        PG(connection_status) = PHP_CONNECTION_NORMAL;
+
+        sapi_activate();
+        t = bridge_metrics_mark(BRIDGE_PHASE_STARTUP, t);
+
+        php_hash_environment();
+        populate_request_globals(req);
+        bridge_metrics_mark(BRIDGE_PHASE_GLOBALS, t);
+
+        EG(exit_status) = 0;
+    } zend_catch {
+        ok = 0;
+    } zend_end_try();
+
+    SG(sapi_started) = 1;
+    return ok;
+}
+
+// php_hash_environment() overwrites PG(http_globals) without releasing it and
+// php_request_shutdown() never runs for a worker request, so drop them here
+static void worker_release_http_globals() {
+    for (int i = 0; i < NUM_TRACK_VARS; i++) {
+        zval_ptr_dtor(&PG(http_globals)[i]);
+        ZVAL_UNDEF(&PG(http_globals)[i]);
+    }
+}
+
+// Flush output and release per-request SAPI state, but keep the engine request alive
+static void worker_request_shutdown() {
+    bridge_metrics_execute_end();
+    bridge_metrics_capture_memory();
+    uint64_t t = bridge_now_ns();
+
+    // register_shutdown_function() callbacks belong to the request that queued them
+    php_call_shutdown_functions();
+    php_free_shutdown_functions();
+
+    zend_try {
+        php_output_end_all();
+    } zend_end_try();
+
+    php_output_deactivate();
+    worker_reset_session();
+
+    zend_try {
+        sapi_deactivate();
+    } zend_end_try();
+
+    worker_release_http_globals();
+    worker_clear_request_info();
+    bridge_metrics_mark(BRIDGE_PHASE_SHUTDOWN, t);
+}
+
+// Drop the worker after a fatal error; the next request boots a fresh one
+static void worker_abandon() {
+    bridge_request_ctx *ctx = bridge_ctx();
+    zval_ptr_dtor(&ctx->worker_handler);
+    ZVAL_UNDEF(&ctx->worker_handler);
+    ctx->worker_booted = 0;
+
+    php_request_shutdown(NULL);
+    worker_clear_request_info();
+}
+
+// Terminate the long-lived worker request (engine shutdown, runner commands)
+static void worker_stop() {
+    bridge_request_ctx *ctx = bridge_ctx();
+    if (!ctx->worker_booted) return;
+
+    LOGI("🛑 Stopping PHP worker");
+    zend_try {
+        php_output_activate();
+        sapi_activate();
+    } zend_end_try();
+
+    worker_abandon();
+}
+
+// Returns 1 when the watchdog stopped the request
+static int run_worker_request(bridge_request *req) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    int restart = 0;
+
+    if (!worker_request_startup(req)) {
+        LOGE("❌ Worker request startup failed, restarting worker");
+        worker_abandon();
+        return bridge_watchdog_interrupted();
+    }
+
+    zend_try {
+        zval retval;
+        ZVAL_UNDEF(&retval);
+
+        bridge_metrics_execute_begin();
+        call_user_function(NULL, NULL, &ctx->worker_handler, &retval, 0, NULL);
+        zval_ptr_dtor(&retval);
+
+        if (EG(exception)) {
+            if (zend_is_unwind_exit(EG(exception)) || zend_is_graceful_exit(EG(exception))) {
+                // exit()/die() inside a handler just ends this request
+                zend_clear_exception();
+            } else {
+                zend_exception_error(EG(exception), E_ERROR);
+                zend_clear_exception();
+                restart = 1;
+            }
         }
-        php_initialized = 1;
+    } zend_catch {
+        restart = 1;
+    } zend_end_try();
+
+    int interrupted = bridge_watchdog_interrupted();
+    if (restart) {
+        LOGE("❌ Worker request failed, restarting worker on next request");
+        worker_abandon();
+    } else {
+        worker_request_shutdown();
     }
+    return interrupted;
+}
 
-    // ✅ Set MVC-relevant env vars
-    setenv("REQUEST_URI", uri, 1);
-    setenv("REQUEST_METHOD", method, 1);
-    setenv("SCRIPT_FILENAME", scriptPath, 1);
-    setenv("PHP_SELF", "/mobile_boot.php", 1);
-    setenv("HTTP_HOST", "127.0.0.1", 1);
+// Process-wide values the app reads through getenv(); request data never goes here
+static void export_engine_env() {
     setenv("APP_URL", "http://127.0.0.1", 1);
     setenv("ASSET_URL", "http://127.0.0.1/_assets/", 1);
     setenv("MVC_MOBILE_RUNNING", "true", 1);
+    setenv("APP_RUNNING_IN_CONSOLE", "false", 1);
+}
 
-    // Explicitly set content type env var if provided (as backup)
-    if (content_type) {
-        setenv("CONTENT_TYPE", content_type, 1);
-    } else {
-        unsetenv("CONTENT_TYPE");
+// Heap policy
+// Zend MM keeps freed chunks cached for reuse and a resident worker keeps its
+// heap between requests, so one large render would pin its peak for the rest
+// of the session. When the heap left after a request crosses the high-water
+// mark (MVC_HEAP_HIGH_WATER_MB, 24 by default) cached chunks and empty pages
+// go back to the system. onTrimMemory (trim_if_requested) does the same on
+// demand and also collects garbage cycles.
+#define HEAP_HIGH_WATER_DEFAULT_MB 24
+
+static size_t g_heap_high_water = (size_t) HEAP_HIGH_WATER_DEFAULT_MB * 1024 * 1024;
+
+static void read_heap_high_water() {
+    const char *value = getenv("MVC_HEAP_HIGH_WATER_MB");
+    long mb = value ? strtol(value, NULL, 10) : 0;
+    g_heap_high_water = (size_t) (mb > 0 ? mb : HEAP_HIGH_WATER_DEFAULT_MB) * 1024 * 1024;
+}
+
+static void heap_after_request() {
+    size_t heap = bridge_ctx()->metrics.heap_size;
+    if (heap <= g_heap_high_water) return;
+
+    size_t released = zend_mm_gc(zend_mm_get_heap());
+    LOGI("🧹 Heap at %zuKB after request (high-water %zuKB), released %zuKB",
+         heap / 1024, g_heap_high_water / 1024, released / 1024);
+}
+
+static int engine_init(void) {
+    return php_embed_init(0, NULL);
+}
+
+static int engine_shutdown(void) {
+    php_embed_shutdown();
+    return SUCCESS;
+}
+
+// Start the embed engine once per process (or again after a runner command tore it down).
+// The SAPI callbacks are process-wide, so they are only written here, under the
+// exclusive lock; php_embed_init() copies php_embed_module into sapi_module.
+static int ensure_engine_started() {
+    int ok = 1;
+
+    ENGINE_LOCK_EXCLUSIVE();
+    if (!php_initialized) {
+        export_engine_env();
+        read_heap_high_water();
+        php_embed_module.ub_write = capture_php_output;
+        php_embed_module.phpinfo_as_text = 1;
+        php_embed_module.php_ini_ignore = 0;
+        php_embed_module.send_headers = bridge_send_headers;
+        android_sapi_install(&php_embed_module);
+
+        if (engine_owner_run(engine_init) == SUCCESS) {
+            php_initialized = 1;
+        } else {
+            ok = 0;
+        }
     }
+    ENGINE_UNLOCK();
 
-    // ✅ Set QUERY_STRING and defer parsing
-    const char* query_string = "";
-    const char* query_start = strchr(uri, '?');
-    if (query_start && strlen(query_start + 1) > 0) {
-        query_string = query_start + 1;
-        setenv("QUERY_STRING", query_string, 1);
-        LOGI("✅ Set QUERY_STRING: %s", query_string);
-    } else {
-        unsetenv("QUERY_STRING");
-        LOGI("⚠️ No QUERY_STRING found in URI");
+    return ok;
+}
+
+static int run_php_script_locked(bridge_request *req);
+static void trim_if_requested();
+
+// Run one request; the response is left in bridge_ctx() (status_code, headers, output)
+void run_php_script_once(bridge_request *req) {
+    if (!ensure_engine_started()) {
+        set_error_response(500, "PHP init failed.");
+        return;
     }
 
-    // ✅ Activate Zend and parse query data AFTER engine is live
-    zend_first_try {
-                zend_activate_modules();
+    ENGINE_LOCK_SHARED();
+    bridge_thread_attach();
+    bridge_metrics_begin(req, bridge_ctx()->worker_booted);
+    bridge_profiler_begin();
+    bridge_sampler_begin(req);
+    bridge_watchdog_arm(req);
+    int interrupted = run_php_script_locked(req);
+
+    // A deadline that passed during shutdown or output flush leaves a complete
+    // response; only a script the watchdog actually stopped gets the 503
+    uint64_t elapsed_ms = 0;
+    if (bridge_watchdog_disarm(&elapsed_ms) && interrupted) {
+        set_timeout_response(elapsed_ms);
+    }
+    bridge_sampler_end();
+    bridge_metrics_end();
+    bridge_profiler_end(&bridge_ctx()->metrics);
+    heap_after_request();
+    trim_if_requested();
+
+    // A buffered response gets the complete breakdown, shutdown included
+    if (!bridge_ctx()->streaming) {
+        append_server_timing(1);
+    }
+    ENGINE_UNLOCK();
+}
 
-                if (strlen(query_string) > 0) {
-                    zend_string *query = zend_string_init(query_string, strlen(query_string), 0);
-                    sapi_module.treat_data(PARSE_GET, query->val, NULL);
-                    zend_string_free(query);
-                    LOGI("✅ Parsed query string into $_GET");
-                }
+// Returns 1 when the watchdog stopped the script
+static int run_php_script_locked(bridge_request *req) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    clear_collected_output();
+    clear_header_buffer();
 
-                // ✅ Set up POST data (if needed)
-                initialize_php_with_request(postData ?: "", method, uri, content_type);
+    if (ctx->worker_booted) {
+        // ✅ Hot path: framework already booted, just feed the request to the worker
+        return run_worker_request(req);
+    }
+
+    int boot_worker = worker_mode_enabled();
+
+    // Request startup parses the query string, cookies and body exactly once
+    // (php_hash_environment through the Android SAPI callbacks)
+    zend_first_try {
+                initialize_php_with_request(req);
 
                 // ✅ Execute the PHP script
                 zend_file_handle fileHandle;
-                zend_stream_init_filename(&fileHandle, scriptPath);
+                zend_stream_init_filename(&fileHandle, req->script_path);
+                bridge_metrics_execute_begin();
                 php_execute_script(&fileHandle);
+                bridge_metrics_execute_end();
 
                 LOGI("✅ PHP script finished executing");
 
-                if (strlen(query_string) > 0) {
-                    zend_string *query2 = zend_string_init(query_string, strlen(query_string), 0);
-                    sapi_module.treat_data(PARSE_GET, query2->val, NULL);
-                    zend_string_free(query2);
-                    LOGI("✅ Re-parsed query string after php_execute_script()");
+                if (boot_worker && worker_capture_handler()) {
+                    ctx->worker_booted = 1;
+                    LOGI("🔥 PHP worker booted, framework stays resident");
                 }
-
             } zend_end_try();
 
+    // Request shutdown resets EG(timed_out), so ask before it runs
+    int interrupted = bridge_watchdog_interrupted();
 
-    // ✅ End request lifecycle
-    php_request_shutdown(NULL);
-
-    // ✅ Compose HTTP response: status + headers + CRLF + body
-    const char *status = (g_status_line[0] != '\0') ? g_status_line : "HTTP/1.1 200 OK";
-    const char *body = g_collected_output ? g_collected_output : "";
-    size_t status_len = strlen(status);
-    size_t headers_len = g_header_buffer ? g_header_length : 0;
-    size_t body_len = strlen(body);
-
-    size_t total = status_len + 2 + headers_len + 2 + body_len + 1;
-    char *response = (char *) malloc(total);
-    if (!response) {
-        return strdup("HTTP/1.1 500 Internal Server Error\r\nContent-Type: text/plain\r\n\r\nAllocation failure");
-    }
-    size_t pos = 0;
-    memcpy(response + pos, status, status_len); pos += status_len;
-    response[pos++] = '\r'; response[pos++] = '\n';
-    if (headers_len > 0) {
-        memcpy(response + pos, g_header_buffer, headers_len); pos += headers_len;
-    }
-    response[pos++] = '\r'; response[pos++] = '\n';
-    if (body_len > 0) {
-        memcpy(response + pos, body, body_len); pos += body_len;
+    // ✅ End request lifecycle (a booted worker keeps its request open)
+    if (ctx->worker_booted) {
+        worker_request_shutdown();
+    } else {
+        bridge_metrics_execute_end();
+        bridge_metrics_capture_memory();
+        uint64_t t = bridge_now_ns();
+        php_request_shutdown(NULL);
+        bridge_metrics_mark(BRIDGE_PHASE_SHUTDOWN, t);
     }
-    response[pos] = '\0';
-
-    return response;
+    return interrupted;
 }
 
 JNIEXPORT void JNICALL native_initialize(JNIEnv *env, jobject thiz) {
@@ -320,15 +898,8 @@ JNIEXPORT void JNICALL native_initialize(JNIEnv *env, jobject thiz) {
     g_bridge_instance = (*env)->NewGlobalRef(env, thiz);
     LOGI("Set g_bridge_instance to %p", g_bridge_instance);
 
-    // Configure the embed SAPI
-    php_embed_module.ub_write = capture_php_output;
-    php_embed_module.phpinfo_as_text = 1;
-    php_embed_module.php_ini_ignore = 0;
-
-    // Initialize PHP
-    if (php_embed_init(0, NULL) == SUCCESS) {
-        php_initialized = 1;
-        sapi_module.header_handler = php_embed_module.header_handler;
+    // Initialize PHP (this also configures the embed SAPI)
+    if (ensure_engine_started()) {
         LOGI("PHP initialized successfully");
     } else {
         LOGI("PHP initialization failed");
@@ -343,7 +914,11 @@ JNIEXPORT jint JNICALL native_set_env(JNIEnv *env, jobject thiz,
     const char *nameStr = (*env)->GetStringUTFChars(env, name, NULL);
     const char *valueStr = (*env)->GetStringUTFChars(env, value, NULL);
 
+    // Requests read the environment through getenv() and the $_SERVER template
+    ENGINE_LOCK_EXCLUSIVE();
     int result = setenv(nameStr, valueStr, overwrite);
+    if (result == 0) android_server_template_override(nameStr);
+    ENGINE_UNLOCK();
 
     (*env)->ReleaseStringUTFChars(env, name, nameStr);
     (*env)->ReleaseStringUTFChars(env, value, valueStr);
@@ -351,36 +926,138 @@ JNIEXPORT jint JNICALL native_set_env(JNIEnv *env, jobject thiz,
     return result;
 }
 
-JNIEXPORT void JNICALL native_set_request_info(JNIEnv *env, jobject thiz,
-                                                     jstring method, jstring uri,
-                                                     jstring post_data, jstring content_type) {
+// Runner commands
+// A runner command is one more request inside the running engine, so first
+// launch no longer restarts PHP around every migration. argv reaches the script
+// through SG(request_info) ($argv, $_SERVER['argv']) and the app root is the
+// working directory for that request only; with ZTS the virtual CWD makes it
+// per interpreter, with NTS the previous directory is restored afterwards.
+#define RUNNER_MAX_ARGS 128
+
+static int is_arg_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Split a command line into argv, in place. Whitespace separates arguments,
+// '...' is taken literally, "..." honours \" and \\, and a backslash outside
+// quotes escapes the next character.
+static int runner_split_args(char *line, char **argv, int max_args) {
+    int argc = 0;
+    char *in = line;
+    char *out = line;
+
+    while (argc < max_args) {
+        while (is_arg_space(*in)) in++;
+        if (!*in) break;
+
+        argv[argc++] = out;
+        char quote = 0;
+        for (; *in; in++) {
+            char c = *in;
+            if (quote == '\'') {
+                if (c == '\'') quote = 0; else *out++ = c;
+            } else if (quote == '"') {
+                if (c == '"') quote = 0;
+                else if (c == '\\' && (in[1] == '"' || in[1] == '\\')) *out++ = *++in;
+                else *out++ = c;
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+            } else if (c == '\\' && in[1]) {
+                *out++ = *++in;
+            } else if (is_arg_space(c)) {
+                in++;
+                break;
+            } else {
+                *out++ = c;
+            }
+        }
+        *out++ = '\0';
+    }
+    return argc;
+}
 
-    const char *methodStr = (*env)->GetStringUTFChars(env, method, NULL);
-    const char *uriStr = (*env)->GetStringUTFChars(env, uri, NULL);
-    const char *postStr = post_data ? (*env)->GetStringUTFChars(env, post_data, NULL) : "";
-    const char *ctStr = content_type ? (*env)->GetStringUTFChars(env, content_type, NULL) : NULL;
+// Run one runner command as a request; its output is left in bridge_ctx()->output
+static void run_runner_locked(const char *runner_path, const char *app_root, const char *command) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    clear_collected_output();
+    clear_header_buffer();
 
-    initialize_php_with_request(postStr, methodStr, uriStr, ctStr);
+    char *line = strdup(command);
+    char *argv[RUNNER_MAX_ARGS + 2];
+    int argc = 0;
+    argv[argc++] = "runner";
+    if (line) {
+        argc += runner_split_args(line, argv + 1, RUNNER_MAX_ARGS);
+    }
+    argv[argc] = NULL;
 
-    (*env)->ReleaseStringUTFChars(env, method, methodStr);
-    (*env)->ReleaseStringUTFChars(env, uri, uriStr);
-    if (post_data) {
-        (*env)->ReleaseStringUTFChars(env, post_data, postStr);
+    char saved_cwd[MAXPATHLEN];
+    int restore_cwd = VCWD_GETCWD(saved_cwd, sizeof(saved_cwd)) != NULL;
+
+    worker_clear_request_info();
+    SG(request_info).argc = argc;
+    SG(request_info).argv = argv;
+    ctx->runner = 1;
+
+    if (php_request_startup() == SUCCESS) {
+        zend_first_try {
+            // Console request: no HTTP head, errors go to the captured output
+            SG(headers_sent) = 1;
+            SG(request_info).no_headers = 1;
+            zend_string *display_errors = zend_string_init(ZEND_STRL("display_errors"), 0);
+            zend_alter_ini_entry_chars(display_errors, "1", 1, PHP_INI_SYSTEM, PHP_INI_STAGE_RUNTIME);
+            zend_string_release(display_errors);
+
+            if (VCWD_CHDIR(app_root) != 0) {
+                LOGE("❌ Could not change CWD to %s", app_root);
+            }
+
+            // Force STDOUT/STDERR through php://output so Symfony StreamOutput works
+            zend_eval_string(
+                    "if (!defined('STDOUT')) define('STDOUT', fopen('php://output', 'w')); "
+                    "if (!defined('STDERR')) define('STDERR', fopen('php://output', 'w'));",
+                    NULL, "patch_stdio"
+            );
+
+            zend_file_handle file_handle;
+            zend_stream_init_filename(&file_handle, runner_path);
+            php_execute_script(&file_handle);
+        } zend_end_try();
+
+        php_request_shutdown(NULL);
+    } else {
+        LOGE("❌ Runner request startup failed");
     }
-    if (content_type) {
-        (*env)->ReleaseStringUTFChars(env, content_type, ctStr);
+
+    if (restore_cwd) {
+        VCWD_CHDIR(saved_cwd);
     }
+    ctx->runner = 0;
+    SG(request_info).argc = 0;
+    SG(request_info).argv = NULL;
+    free(line);
 }
 
-JNIEXPORT jstring JNICALL native_run_runner_command(JNIEnv *env, jobject thiz, jstring jcommand) {
-    const char *command = (*env)->GetStringUTFChars(env, jcommand, NULL);
-    LOGI("🛠️ runRunnerCommand: %s", command);
+// Run several runner commands in order, one output string per command
+JNIEXPORT jobjectArray JNICALL native_run_runner_commands(JNIEnv *env, jobject thiz, jobjectArray jcommands) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    jsize count = (*env)->GetArrayLength(env, jcommands);
+    jclass stringClass = (*env)->FindClass(env, "java/lang/String");
+    jobjectArray outputs = (*env)->NewObjectArray(env, count, stringClass, NULL);
+    (*env)->DeleteLocalRef(env, stringClass);
+    if (!outputs) return NULL;
 
-    clear_collected_output();
-    php_embed_module.ub_write = capture_php_output;
-    php_embed_module.phpinfo_as_text = 1;
-    php_embed_module.php_ini_ignore = 0;
-    php_embed_module.ini_entries = "display_errors=1\nimplicit_flush=1\noutput_buffering=0\n";
+    // Reuse the running engine; only the very first call starts it
+    native_initialize(env, thiz);
+    if (!php_initialized) {
+        LOGE("❌ Failed to initialize PHP runtime");
+        jstring empty = (*env)->NewStringUTF(env, "");
+        for (jsize i = 0; i < count; i++) {
+            (*env)->SetObjectArrayElement(env, outputs, i, empty);
+        }
+        (*env)->DeleteLocalRef(env, empty);
+        return outputs;
+    }
 
     // Resolve App root path (not public) to locate runner correctly
     jclass cls = (*env)->GetObjectClass(env, thiz);
@@ -388,167 +1065,406 @@ JNIEXPORT jstring JNICALL native_run_runner_command(JNIEnv *env, jobject thiz, j
     jstring jAppRoot = (jstring)(*env)->CallObjectMethod(env, thiz, getAppPathMethod);
     const char *cAppRoot = (*env)->GetStringUTFChars(env, jAppRoot, NULL);
 
-    native_initialize(env, thiz);
-
     // runner resides under app root
     char runnerPath[1024];
     snprintf(runnerPath, sizeof(runnerPath), "%s/runner", cAppRoot);
-    char basePath[1024];
-    snprintf(basePath, sizeof(basePath), "%s", cAppRoot);
-    chdir(basePath);
-    LOGI("✅ Changed CWD to Base: %s", basePath);
 
-    // Ensure mobile flags are present so .env does not override persisted DB env
-    setenv("MVC_MOBILE_RUNNING", "true", 1);
-    setenv("APP_RUNNING_IN_CONSOLE", "true", 1);
-    setenv("PHP_SELF", "runner", 1);
-    setenv("APP_ENV", "local", 1);
-
-    // Tokenize command
-    char *argv[128];
-    int argc = 0;
-    argv[argc++] = "php";
+    ENGINE_LOCK_SHARED();
+    bridge_thread_attach();
 
-    char *commandCopy = strdup(command);
-    char *token = strtok(commandCopy, " ");
-    while (token && argc < 127) {
-        argv[argc++] = token;
-        token = strtok(NULL, " ");
-    }
-    argv[argc] = NULL;
+    // Commands may change the schema or config the resident worker booted
+    // with; it boots again on the next page request
+    worker_stop();
 
-    if (php_initialized) {
-        php_embed_shutdown();
-        php_initialized = 0;
-    }
+    for (jsize i = 0; i < count; i++) {
+        jstring jcommand = (jstring) (*env)->GetObjectArrayElement(env, jcommands, i);
+        const char *command = jcommand ? (*env)->GetStringUTFChars(env, jcommand, NULL) : "";
+        LOGI("🛠️ runRunnerCommand: %s", command);
 
-    if (php_embed_init(argc, argv) == SUCCESS) {
-        php_initialized = 1;
+        run_runner_locked(runnerPath, cAppRoot, command);
 
-        // Force STDOUT/STDERR through php://output so Symfony StreamOutput works
-        zend_eval_string(
-                "if (!defined('STDOUT')) define('STDOUT', fopen('php://output', 'w')); "
-                "if (!defined('STDERR')) define('STDERR', fopen('php://output', 'w'));",
-                NULL, "patch_stdio"
-        );
+        jstring output = (*env)->NewStringUTF(env, ctx->output ? ctx->output : "");
+        (*env)->SetObjectArrayElement(env, outputs, i, output);
+        (*env)->DeleteLocalRef(env, output);
 
-        zend_file_handle file_handle;
-        zend_stream_init_filename(&file_handle, runnerPath);
-        php_execute_script(&file_handle);
-        php_embed_shutdown();
-        php_initialized = 0;
-    } else {
-        LOGE("❌ Failed to initialize PHP runtime");
+        if (jcommand) {
+            (*env)->ReleaseStringUTFChars(env, jcommand, command);
+            (*env)->DeleteLocalRef(env, jcommand);
+        }
     }
+    ENGINE_UNLOCK();
 
-    (*env)->ReleaseStringUTFChars(env, jcommand, command);
     (*env)->ReleaseStringUTFChars(env, jAppRoot, cAppRoot);
     (*env)->DeleteLocalRef(env, jAppRoot);
-    free(commandCopy);
+    (*env)->DeleteLocalRef(env, cls);
+
+    return outputs;
+}
+
+JNIEXPORT jstring JNICALL native_run_runner_command(JNIEnv *env, jobject thiz, jstring jcommand) {
+    jclass stringClass = (*env)->FindClass(env, "java/lang/String");
+    jobjectArray commands = (*env)->NewObjectArray(env, 1, stringClass, jcommand);
+    (*env)->DeleteLocalRef(env, stringClass);
+
+    jobjectArray outputs = commands ? native_run_runner_commands(env, thiz, commands) : NULL;
+    jstring output = outputs ? (jstring) (*env)->GetObjectArrayElement(env, outputs, 0) : NULL;
+
+    (*env)->DeleteLocalRef(env, commands);
+    (*env)->DeleteLocalRef(env, outputs);
+    return output ? output : (*env)->NewStringUTF(env, "");
+}
 
-    return (*env)->NewStringUTF(env, g_collected_output ? g_collected_output : "");
+// Context.getDir("storage") of the PHPBridge, which holds app/ and app/public.
+// It cannot change while the process lives, so the JNI reflection runs once.
+static char g_storage_dir[1024];
+static pthread_mutex_t g_storage_dir_lock = PTHREAD_MUTEX_INITIALIZER;
+
+const char *bridge_storage_dir(JNIEnv *env, jobject bridge) {
+    pthread_mutex_lock(&g_storage_dir_lock);
+    if (!g_storage_dir[0]) {
+        // Get context from the PHPBridge instance
+        jclass bridgeClass = (*env)->GetObjectClass(env, bridge);
+        jfieldID contextFieldId = (*env)->GetFieldID(env, bridgeClass, "context", "Landroid/content/Context;");
+        jobject context = (*env)->GetObjectField(env, bridge, contextFieldId);
+
+        // Call getDir method on the context
+        jclass contextClass = (*env)->GetObjectClass(env, context);
+        jmethodID getDirMethod = (*env)->GetMethodID(env, contextClass, "getDir", "(Ljava/lang/String;I)Ljava/io/File;");
+        jstring dirName = (*env)->NewStringUTF(env, "storage");
+        jint mode = 0; // MODE_PRIVATE
+        jobject storageDir = (*env)->CallObjectMethod(env, context, getDirMethod, dirName, mode);
+
+        // Get the absolute path from the file object
+        jclass fileClass = (*env)->GetObjectClass(env, storageDir);
+        jmethodID getAbsolutePathMethod = (*env)->GetMethodID(env, fileClass, "getAbsolutePath", "()Ljava/lang/String;");
+        jstring storagePath = (jstring) (*env)->CallObjectMethod(env, storageDir, getAbsolutePathMethod);
+
+        const char *cStoragePath = (*env)->GetStringUTFChars(env, storagePath, NULL);
+        snprintf(g_storage_dir, sizeof(g_storage_dir), "%s", cStoragePath);
+
+        // Release resources
+        (*env)->ReleaseStringUTFChars(env, storagePath, cStoragePath);
+        (*env)->DeleteLocalRef(env, dirName);
+        (*env)->DeleteLocalRef(env, storageDir);
+        (*env)->DeleteLocalRef(env, storagePath);
+        (*env)->DeleteLocalRef(env, fileClass);
+        (*env)->DeleteLocalRef(env, contextClass);
+        (*env)->DeleteLocalRef(env, context);
+        (*env)->DeleteLocalRef(env, bridgeClass);
+    }
+    pthread_mutex_unlock(&g_storage_dir_lock);
+    return g_storage_dir;
 }
 
 JNIEXPORT jstring JNICALL native_get_app_path(JNIEnv *env, jobject thiz) {
-    // Get context from the PHPBridge instance
-    jclass bridgeClass = (*env)->GetObjectClass(env, thiz);
-    jfieldID contextFieldId = (*env)->GetFieldID(env, bridgeClass, "context", "Landroid/content/Context;");
-    jobject context = (*env)->GetObjectField(env, thiz, contextFieldId);
-
-    // Call getDir method on the context
-    jclass contextClass = (*env)->GetObjectClass(env, context);
-    jmethodID getDirMethod = (*env)->GetMethodID(env, contextClass, "getDir", "(Ljava/lang/String;I)Ljava/io/File;");
-    jstring dirName = (*env)->NewStringUTF(env, "storage");
-    jint mode = 0; // MODE_PRIVATE
-    jobject storageDir = (*env)->CallObjectMethod(env, context, getDirMethod, dirName, mode);
-
-    // Get the absolute path from the file object
-    jclass fileClass = (*env)->GetObjectClass(env, storageDir);
-    jmethodID getAbsolutePathMethod = (*env)->GetMethodID(env, fileClass, "getAbsolutePath", "()Ljava/lang/String;");
-    jstring storagePath = (jstring) (*env)->CallObjectMethod(env, storageDir, getAbsolutePathMethod);
-
-    // Convert to C string for concatenation
-    const char *cStoragePath = (*env)->GetStringUTFChars(env, storagePath, NULL);
-
-    // Concatenate with "/app"
     char fullPath[1024];
-    sprintf(fullPath, "%s/app", cStoragePath);
+    snprintf(fullPath, sizeof(fullPath), "%s/app", bridge_storage_dir(env, thiz));
+    return (*env)->NewStringUTF(env, fullPath);
+}
+
+// PHPResponse(int status, String reason, String[] headerNames, String[] headerValues, byte[] body,
+//             int fileFd, long fileOffset, long fileLength)
+static jclass g_response_class = NULL;
+static jmethodID g_response_ctor = NULL;
+static jclass g_string_class = NULL;
+
+// Header names (values = 0) or values (values = 1) of the captured head as a String[]
+static jobjectArray header_array(JNIEnv *env, int values) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    jobjectArray array = (*env)->NewObjectArray(env, (jsize) ctx->header_count, g_string_class, NULL);
+    if (!array) return NULL;
+
+    const char *p = ctx->headers;
+    for (size_t i = 0; i < ctx->header_count; i++) {
+        const char *name = p;
+        const char *value = name + strlen(name) + 1;
+        p = value + strlen(value) + 1;
+
+        jstring item = (*env)->NewStringUTF(env, values ? value : name);
+        (*env)->SetObjectArrayElement(env, array, (jsize) i, item);
+        if (item) (*env)->DeleteLocalRef(env, item);
+    }
+    return array;
+}
 
-    // Release resources
-    (*env)->ReleaseStringUTFChars(env, storagePath, cStoragePath);
-    (*env)->DeleteLocalRef(env, dirName);
-    (*env)->DeleteLocalRef(env, storageDir);
-    (*env)->DeleteLocalRef(env, storagePath);
+// PHPResponse for a failure found while building the real one
+static jobject build_error_response(JNIEnv *env, int status, const char *message) {
+    set_error_response(status, message);
 
-    // Return the final path
-    return (*env)->NewStringUTF(env, fullPath);
+    bridge_request_ctx *ctx = bridge_ctx();
+    jbyteArray body = (*env)->NewByteArray(env, (jsize) ctx->output_length);
+    if (!body) {
+        (*env)->ExceptionClear(env);
+        body = (*env)->NewByteArray(env, 0);
+    } else {
+        (*env)->SetByteArrayRegion(env, body, 0, (jsize) ctx->output_length, (const jbyte *) ctx->output);
+    }
+
+    jstring reason = (*env)->NewStringUTF(env, status_text(status));
+    jobjectArray names = header_array(env, 0);
+    jobjectArray values = header_array(env, 1);
+    jobject response = (*env)->NewObject(env, g_response_class, g_response_ctor,
+                                         (jint) status, reason, names, values, body,
+                                         (jint) -1, (jlong) 0, (jlong) 0);
+
+    (*env)->DeleteLocalRef(env, reason);
+    (*env)->DeleteLocalRef(env, names);
+    (*env)->DeleteLocalRef(env, values);
+    (*env)->DeleteLocalRef(env, body);
+    return response;
 }
 
-JNIEXPORT jstring JNICALL native_handle_request_once(
-        JNIEnv *env, jobject thiz,
-        jstring jMethod, jstring jUri, jstring jPostData, jstring jContentType, jstring jScriptPath) {
+// Build the PHPResponse for the current context; the body byte[] is the only
+// copy of the output (empty for a streamed head, whose body goes down the pipe).
+// A file response carries no byte[] body: its descriptor and slice go to
+// Kotlin, which reads the file through a bounded stream.
+static jobject build_response(JNIEnv *env, int with_body) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    off_t file_offset = 0;
+    size_t file_len = 0;
+    int file_fd = -1;
+
+    if (with_body && ctx->sendfile_active && ctx->sendfile_length > 0) {
+        file_fd = bridge_sendfile_detach(&file_offset, &file_len);
+        if (file_fd < 0) return build_error_response(env, 500, "File response could not be read.");
+    }
 
-    const char *method = (*env)->GetStringUTFChars(env, jMethod, NULL);
-    const char *uri = (*env)->GetStringUTFChars(env, jUri, NULL);
-    const char *post = jPostData ? (*env)->GetStringUTFChars(env, jPostData, NULL) : "";
-    const char *ctype = jContentType ? (*env)->GetStringUTFChars(env, jContentType, NULL) : NULL;
-    const char *path = (*env)->GetStringUTFChars(env, jScriptPath, NULL);
+    size_t body_len = (file_fd < 0 && with_body && ctx->output) ? ctx->output_length : 0;
+    if (body_len > INT32_MAX) {
+        LOGE("❌ %zu byte response body does not fit a byte[]", body_len);
+        return build_error_response(env, 500, "Response too large.");
+    }
 
-    char *output = run_php_script_once(path, method, uri, post, ctype);
+    jbyteArray body = (*env)->NewByteArray(env, (jsize) body_len);
+    if (!body) {
+        LOGE("❌ Failed to allocate %zu byte response body", body_len);
+        (*env)->ExceptionClear(env);
+        if (file_fd >= 0) close(file_fd);
+        return build_error_response(env, 500, "Response body could not be allocated.");
+    }
+    if (body_len > 0) {
+        (*env)->SetByteArrayRegion(env, body, 0, (jsize) body_len, (const jbyte *) ctx->output);
+    }
 
-    jstring result = (*env)->NewStringUTF(env, output ? output : "");
+    jstring reason = (*env)->NewStringUTF(env, status_text(ctx->status_code));
+    jobjectArray names = header_array(env, 0);
+    jobjectArray values = header_array(env, 1);
 
-    // Clean up
-    free(output);
-    (*env)->ReleaseStringUTFChars(env, jMethod, method);
-    (*env)->ReleaseStringUTFChars(env, jUri, uri);
-    (*env)->ReleaseStringUTFChars(env, jScriptPath, path);
-    if (jPostData) (*env)->ReleaseStringUTFChars(env, jPostData, post);
-    if (jContentType) (*env)->ReleaseStringUTFChars(env, jContentType, ctype);
+    jobject response = (*env)->NewObject(env, g_response_class, g_response_ctor,
+                                         (jint) ctx->status_code, reason, names, values, body,
+                                         (jint) file_fd, (jlong) file_offset, (jlong) file_len);
+    if (!response && file_fd >= 0) {
+        (*env)->ExceptionClear(env);
+        close(file_fd);
+    }
 
-    return result;
+    (*env)->DeleteLocalRef(env, reason);
+    (*env)->DeleteLocalRef(env, names);
+    (*env)->DeleteLocalRef(env, values);
+    (*env)->DeleteLocalRef(env, body);
+    return response;
 }
 
-JNIEXPORT jstring JNICALL native_get_app_public_path(JNIEnv *env, jobject thiz) {
-    // Get context from the PHPBridge instance
-    jclass bridgeClass = (*env)->GetObjectClass(env, thiz);
-    jfieldID contextFieldId = (*env)->GetFieldID(env, bridgeClass, "context", "Landroid/content/Context;");
-    jobject context = (*env)->GetObjectField(env, thiz, contextFieldId);
-
-    // Call getDir method on the context
-    jclass contextClass = (*env)->GetObjectClass(env, context);
-    jmethodID getDirMethod = (*env)->GetMethodID(env, contextClass, "getDir", "(Ljava/lang/String;I)Ljava/io/File;");
-    jstring dirName = (*env)->NewStringUTF(env, "storage");
-    jint mode = 0; // MODE_PRIVATE
-    jobject storageDir = (*env)->CallObjectMethod(env, context, getDirMethod, dirName, mode);
-
-    // Get the absolute path from the file object
-    jclass fileClass = (*env)->GetObjectClass(env, storageDir);
-    jmethodID getAbsolutePathMethod = (*env)->GetMethodID(env, fileClass, "getAbsolutePath", "()Ljava/lang/String;");
-    jstring storagePath = (jstring) (*env)->CallObjectMethod(env, storageDir, getAbsolutePathMethod);
-
-    // Convert to C string for concatenation
-    const char *cStoragePath = (*env)->GetStringUTFChars(env, storagePath, NULL);
-    setenv("APP_RUNNING_IN_CONSOLE", "false", 1);
+// Request record
+// PHPBridge packs each request into one direct ByteBuffer (see RequestRecord.kt).
+// Strings are NUL-terminated inside the buffer, so the decoded bridge_request
+// points straight into it; only the two header pointer arrays are allocated.
+#define REQUEST_RECORD_VERSION 1
+
+typedef struct {
+    const char *data;
+    size_t length;
+    size_t pos;
+} record_reader;
+
+static int record_u32(record_reader *r, uint32_t *out) {
+    if (r->length - r->pos < sizeof(uint32_t)) return 0;
+    memcpy(out, r->data + r->pos, sizeof(uint32_t));
+    r->pos += sizeof(uint32_t);
+    return 1;
+}
 
-    // Concatenate with "/app/public"
-    char fullPath[1024];
-    sprintf(fullPath, "%s/app/public", cStoragePath);
+static int record_str(record_reader *r, const char **out, size_t *out_length) {
+    uint32_t length;
+    if (!record_u32(r, &length)) return 0;
+    if (r->length - r->pos < (size_t) length + 1 || r->data[r->pos + length] != '\0') return 0;
+    *out = r->data + r->pos;
+    if (out_length) *out_length = length;
+    r->pos += (size_t) length + 1;
+    return 1;
+}
 
-    // Release resources
-    (*env)->ReleaseStringUTFChars(env, storagePath, cStoragePath);
-    (*env)->DeleteLocalRef(env, dirName);
-    (*env)->DeleteLocalRef(env, storageDir);
-    (*env)->DeleteLocalRef(env, storagePath);
+static int request_decode(bridge_request *req, const char *data, size_t length) {
+    record_reader r = { data, length, 0 };
+    uint32_t version, count;
 
-    // Return the final path
+    memset(req, 0, sizeof(*req));
+
+    if (!record_u32(&r, &version) || version != REQUEST_RECORD_VERSION) {
+        LOGE("❌ Unsupported request record version");
+        return 0;
+    }
+    if (!record_str(&r, &req->method, NULL) ||
+        !record_str(&r, &req->uri, NULL) ||
+        !record_str(&r, &req->script_path, NULL) ||
+        !record_u32(&r, &count)) {
+        LOGE("❌ Truncated request record");
+        return 0;
+    }
+
+    req->header_names = calloc(count ? count : 1, sizeof(char *));
+    req->header_values = calloc(count ? count : 1, sizeof(char *));
+    if (!req->header_names || !req->header_values) return 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (!record_str(&r, &req->header_names[i], NULL) ||
+            !record_str(&r, &req->header_values[i], NULL)) {
+            LOGE("❌ Truncated request record headers");
+            return 0;
+        }
+        req->header_count++;
+
+        if (strcasecmp(req->header_names[i], "Content-Type") == 0) {
+            req->content_type = req->header_values[i];
+        } else if (strcasecmp(req->header_names[i], "Cookie") == 0) {
+            req->cookie = req->header_values[i];
+        }
+    }
+
+    if (!record_str(&r, &req->body, &req->body_length)) {
+        LOGE("❌ Truncated request record body");
+        return 0;
+    }
+
+    const char *query_start = strchr(req->uri, '?');
+    req->query_string = (query_start && query_start[1] != '\0') ? query_start + 1 : NULL;
+    return 1;
+}
+
+static void request_free(bridge_request *req) {
+    free(req->header_names);
+    free(req->header_values);
+    memset(req, 0, sizeof(*req));
+}
+
+// Decode the record behind a direct ByteBuffer; on failure the context holds a 400 response
+static int request_from_record(JNIEnv *env, bridge_request *req, jobject record, jint length) {
+    const char *data = (const char *) (*env)->GetDirectBufferAddress(env, record);
+    if (data && length > 0 && request_decode(req, data, (size_t) length)) {
+        return 1;
+    }
+
+    request_free(req);
+    set_error_response(400, "Malformed bridge request record.");
+    return 0;
+}
+
+// Answer req from the response cache when possible. The hit is laid out like
+// a PHP response (status, head, output or X-Sendfile) so both delivery paths
+// send it unchanged; the Zend engine is not entered. A hit whose file has
+// gone or changed since it was cached (its head would describe the old file)
+// is evicted and the request goes to PHP instead.
+static int serve_from_cache(bridge_request *req) {
+    bridge_cached_response *hit = bridge_cache_fetch(req);
+    if (!hit) return 0;
+
+    bridge_request_ctx *ctx = bridge_ctx();
+    clear_collected_output();
+    clear_header_buffer();
+
+    // Opened after the clear, which releases any pending file
+    if (hit->file) {
+        bridge_sendfile_header("X-Sendfile", sizeof("X-Sendfile") - 1, hit->file, strlen(hit->file));
+
+        struct stat st;
+        if (!ctx->sendfile_active || fstat(ctx->sendfile_fd, &st) != 0 || st.st_size != hit->file_size ||
+            (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec != hit->file_mtime_ns) {
+            LOGI("🗄️ Cached file for %s is gone or changed, evicting", req->uri);
+            bridge_cache_evict(req);
+            bridge_sendfile_reset();
+            free(hit);
+            return 0;
+        }
+    }
+    ctx->status_code = hit->status;
+
+    const char *p = hit->headers;
+    for (size_t i = 0; i < hit->header_count; i++) {
+        const char *name = p;
+        const char *value = name + strlen(name) + 1;
+        p = value + strlen(value) + 1;
+        append_header(name, strlen(name), value, strlen(value));
+    }
+
+    char age[24];
+    int age_length = snprintf(age, sizeof(age), "%llu", (unsigned long long) hit->age_s);
+    append_header("Age", sizeof("Age") - 1, age, (size_t) age_length);
+    append_header("X-Cache", sizeof("X-Cache") - 1, "HIT", 3);
+
+    if (hit->file) {
+        bridge_sendfile_resolve();
+    } else if (hit->body_length > 0) {
+        append_php_output(hit->body, hit->body_length);
+    }
+    free(hit);
+    return 1;
+}
+
+// Run req through PHP unless the response cache has it; a response whose
+// route asked for caching is stored afterwards
+static void run_cached_or_php(bridge_request *req) {
+    if (serve_from_cache(req)) return;
+
+    run_php_script_once(req);
+
+    bridge_request_ctx *ctx = bridge_ctx();
+    bridge_cache_store(req, ctx->output, ctx->output ? ctx->output_length : 0, ctx->sendfile_path);
+}
+
+JNIEXPORT jobject JNICALL native_handle_request_once(JNIEnv *env, jobject thiz, jobject record, jint length) {
+    bridge_request req;
+    if (request_from_record(env, &req, record, length)) {
+        run_cached_or_php(&req);
+        request_free(&req);
+    }
+
+    jobject response = build_response(env, 1);
+    bridge_sendfile_reset();
+    shrink_response_buffers();
+    return response;
+}
+
+JNIEXPORT void JNICALL native_handle_request_streaming(JNIEnv *env, jobject thiz, jobject record, jint length, jint fd, jobject sink) {
+    bridge_request req;
+    int decoded = request_from_record(env, &req, record, length);
+
+    stream_begin(env, fd, sink);
+    if (decoded) {
+        run_cached_or_php(&req);
+        request_free(&req);
+    }
+    stream_finish();
+    shrink_response_buffers();
+}
+
+JNIEXPORT jstring JNICALL native_get_app_public_path(JNIEnv *env, jobject thiz) {
+    char fullPath[1024];
+    snprintf(fullPath, sizeof(fullPath), "%s/app/public", bridge_storage_dir(env, thiz));
     return (*env)->NewStringUTF(env, fullPath);
 }
 
 JNIEXPORT void JNICALL native_shutdown(JNIEnv *env, jobject thiz) {
+    bridge_request_ctx *ctx = bridge_ctx();
+    ENGINE_LOCK_EXCLUSIVE();
+    bridge_thread_attach();
+
     if (php_initialized) {
-        php_embed_shutdown();
+        // Other threads stopped their workers as they left the drained pool
+        // (interpreter_thread_exit); this one may still hold one
+        worker_stop();
+        engine_owner_run(engine_shutdown);
         php_initialized = 0;
+        g_engine_generation++;
 
         if (g_callback_obj) {
             (*env)->DeleteGlobalRef(env, g_callback_obj);
@@ -562,40 +1478,130 @@ JNIEXPORT void JNICALL native_shutdown(JNIEnv *env, jobject thiz) {
         }
 
         // Free the collected output buffer
-        if (g_collected_output) {
-            free(g_collected_output);
-            g_collected_output = NULL;
-            g_collected_length = 0;
-            g_collected_capacity = 0;
+        if (ctx->output) {
+            free(ctx->output);
+            ctx->output = NULL;
+            ctx->output_length = 0;
+            ctx->output_capacity = 0;
         }
     }
+    ENGINE_UNLOCK();
+}
+
+// onTrimMemory rounds
+// nativeRequestTrim() starts a round; every interpreter trims once per round,
+// in a task Kotlin posts to the pool or, when busy, right after its request.
+// Nothing ever waits for an interpreter to become free.
+
+/**
+ * Compact the calling interpreter's heap if a trim round started since it last
+ * trimmed. full (app in the background) also collects garbage cycles held by
+ * a resident worker. Caller holds the engine lock.
+ */
+static void trim_if_requested() {
+    bridge_request_ctx *ctx = bridge_ctx();
+    unsigned int round = __atomic_load_n(&g_trim_round, __ATOMIC_ACQUIRE);
+    if (ctx->trim_round == round) return;
+    ctx->trim_round = round;
+
+    // A thread that never served a request has no interpreter worth trimming
+    if (!php_initialized || !ctx->thread_attached || ctx->engine_generation != g_engine_generation) return;
+
+    size_t before = zend_memory_usage(1);
+    int cycles = 0;
+
+    // Collecting needs an open request: only the worker's stays open between requests
+    if (__atomic_load_n(&g_trim_full, __ATOMIC_RELAXED) && ctx->worker_booted) {
+        zend_try {
+            cycles = zend_gc_collect_cycles();
+        } zend_end_try();
+    }
+    zend_mm_gc(zend_mm_get_heap());
+
+    LOGI("🧹 Trimmed heap %zuKB -> %zuKB (%d cycles collected)",
+         before / 1024, zend_memory_usage(1) / 1024, cycles);
+}
+
+JNIEXPORT void JNICALL native_request_trim(JNIEnv *env, jobject thiz, jboolean full) {
+    __atomic_store_n(&g_trim_full, full == JNI_TRUE, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&g_trim_round, 1, __ATOMIC_RELEASE);
+}
+
+// Trim task posted to the pool: settle the round for this interpreter if its
+// last request has not already, and give back oversized response buffers
+JNIEXPORT void JNICALL native_trim_memory(JNIEnv *env, jobject thiz) {
+    ENGINE_LOCK_SHARED();
+    trim_if_requested();
+    shrink_response_buffers();
+    ENGINE_UNLOCK();
+}
+
+JNIEXPORT jstring JNICALL native_metrics(JNIEnv *env, jobject thiz) {
+    char *json = bridge_metrics_json();
+    jstring result = (*env)->NewStringUTF(env, json ? json : "[]");
+    free(json);
+    return result;
+}
+
+JNIEXPORT jstring JNICALL native_last_profile(JNIEnv *env, jobject thiz) {
+    char *folded = bridge_profiler_last();
+    if (!folded) return NULL;
+    jstring result = (*env)->NewStringUTF(env, folded);
+    free(folded);
+    return result;
+}
+
+JNIEXPORT jstring JNICALL native_sampler_profile(JNIEnv *env, jobject thiz, jboolean reset) {
+    char *folded = bridge_sampler_folded(reset == JNI_TRUE);
+    if (!folded) return NULL;
+    jstring result = (*env)->NewStringUTF(env, folded);
+    free(folded);
+    return result;
+}
+
+JNIEXPORT jint JNICALL native_max_interpreters(JNIEnv *env, jobject thiz) {
+    return bridge_max_interpreters();
 }
 
 JNIEXPORT jstring JNICALL native_execute_script(JNIEnv *env, jobject thiz, jstring filename) {
+    bridge_request_ctx *ctx = bridge_ctx();
     const char *phpFilePath = (*env)->GetStringUTFChars(env, filename, NULL);
 
+    ENGINE_LOCK_SHARED();
+    bridge_thread_attach();
+
     zend_file_handle file_handle;
     zend_stream_init_filename(&file_handle, phpFilePath);
 
     php_execute_script(&file_handle);
+    ENGINE_UNLOCK();
 
     (*env)->ReleaseStringUTFChars(env, filename, phpFilePath);
 
     // Return collected output
-    return (*env)->NewStringUTF(env, g_collected_output ? g_collected_output : "");
+    return (*env)->NewStringUTF(env, ctx->output ? ctx->output : "");
 }
 
 static JNINativeMethod gMethods[] = {
          // Updated method signature array for PHPBridge
             {"nativeExecuteScript", "(Ljava/lang/String;)Ljava/lang/String;", (void *) native_execute_script},
             {"initialize", "()V", (void *) native_initialize},
-            {"shutdown", "()V", (void *) native_shutdown},
-            {"setRequestInfo", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V", (void *) native_set_request_info},
+            {"nativeShutdown", "()V", (void *) native_shutdown},
             {"runRunnerCommand", "(Ljava/lang/String;)Ljava/lang/String;", (void *) native_run_runner_command},
+            {"runRunnerCommands", "([Ljava/lang/String;)[Ljava/lang/String;", (void *) native_run_runner_commands},
             {"getAppPublicPath", "()Ljava/lang/String;", (void *) native_get_app_public_path},
             {"getAppPath", "()Ljava/lang/String;", (void *) native_get_app_path},
+            {"nativeOpenAsset", "(Ljava/lang/String;)[J", (void *) native_open_asset},
+            {"nativeInvalidateAssets", "()V", (void *) native_invalidate_assets},
             {"nativeSetEnv", "(Ljava/lang/String;Ljava/lang/String;I)I", (void *) native_set_env},
-            {"nativeHandleRequestOnce","(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;",(void *) native_handle_request_once}
+            {"nativeMaxInterpreters", "()I", (void *) native_max_interpreters},
+            {"nativeMetrics", "()Ljava/lang/String;", (void *) native_metrics},
+            {"nativeRequestTrim", "(Z)V", (void *) native_request_trim},
+            {"nativeTrimMemory", "()V", (void *) native_trim_memory},
+            {"nativeLastProfile", "()Ljava/lang/String;", (void *) native_last_profile},
+            {"nativeSamplerProfile", "(Z)Ljava/lang/String;", (void *) native_sampler_profile},
+            {"nativeHandleRequestStreaming", "(Ljava/nio/ByteBuffer;IILcom/fuse/php/bridge/PHPBridge$StreamSink;)V", (void *) native_handle_request_streaming},
+            {"nativeHandleRequestOnce","(Ljava/nio/ByteBuffer;I)Lcom/fuse/php/bridge/PHPResponse;",(void *) native_handle_request_once}
     };
 
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
@@ -616,6 +1622,22 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
         return JNI_ERR;
     }
 
+    // Response type built by native_handle_request_once / the streaming head
+    jclass responseClass = (*env)->FindClass(env, "com/fuse/php/bridge/PHPResponse");
+    jclass stringClass = (*env)->FindClass(env, "java/lang/String");
+    if (responseClass == NULL || stringClass == NULL) {
+        return JNI_ERR;
+    }
+    g_response_class = (jclass) (*env)->NewGlobalRef(env, responseClass);
+    g_string_class = (jclass) (*env)->NewGlobalRef(env, stringClass);
+    g_response_ctor = (*env)->GetMethodID(env, g_response_class, "<init>",
+                                          "(ILjava/lang/String;[Ljava/lang/String;[Ljava/lang/String;[BIJJ)V");
+    (*env)->DeleteLocalRef(env, responseClass);
+    (*env)->DeleteLocalRef(env, stringClass);
+    if (g_response_ctor == NULL) {
+        return JNI_ERR;
+    }
+
     // Register native methods for MobileEnvironment
     jclass mobileEnvClass = (*env)->FindClass(env, "com/fuse/php/bridge/MobileEnvironment");
     if (mobileEnvClass == NULL) {
@@ -636,5 +1658,11 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
         return JNI_ERR;
     }
 
+    // Cache the Java types nativephp_call() marshals to and from
+    if (nativephp_jni_init(env) != JNI_OK) {
+        LOGE("Failed to initialize nativephp marshalling");
+        return JNI_ERR;
+    }
+
     return JNI_VERSION_1_6;
 }
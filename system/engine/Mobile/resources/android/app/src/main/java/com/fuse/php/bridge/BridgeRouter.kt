@@ -2,6 +2,10 @@ package com.fuse.php.bridge
 
 import android.util.Log
 import org.json.JSONObject
+import java.util.concurrent.Executors
+import java.util.concurrent.ThreadFactory
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
 import java.util.concurrent.locks.ReentrantReadWriteLock
 import kotlin.concurrent.read
 import kotlin.concurrent.write
@@ -87,6 +91,15 @@ class BridgeFunctionRegistry private constructor() {
         functions[name]
     }
 
+    /**
+     * Get several functions under a single lock acquisition
+     * @param names The fully qualified function names
+     * @return Implementations in the same order, null where not found
+     */
+    fun getAll(names: List<String?>): List<BridgeFunction?> = lock.read {
+        names.map { name -> name?.let { functions[it] } }
+    }
+
     /**
      * Get all registered function names (useful for debugging)
      */
@@ -193,38 +206,218 @@ fun nativePHPCall(functionName: String, parametersJSON: String?): String? {
         }
     }
 
-    // Get the function
+    val response = executeBridgeFunction(functionName, parameters) ?: return null
+
+    return BridgeResponse.toJSON(response) ?: BridgeResponse.toJSON(
+        BridgeResponse.error(
+            code = "SERIALIZATION_ERROR",
+            message = "Failed to serialize response to JSON"
+        )
+    )
+}
+
+/**
+ * Call a native function through the bridge router without a JSON round trip
+ * Called from the nativephp_call() PHP function via JNI; parameters arrive as
+ * Map/List/String/Long/Double/Boolean marshalled straight from PHP zvals and
+ * the returned map is marshalled straight back into a PHP array.
+ * @param functionName The fully qualified function name (e.g., "Location.Get")
+ * @param parameters Parameters passed from PHP
+ * @return Result or error map, or null if function doesn't exist
+ */
+@Suppress("unused") // Called from JNI
+fun nativePHPCallMap(functionName: String, parameters: Map<String, Any?>): Map<String, Any>? {
+    @Suppress("UNCHECKED_CAST")
+    return executeBridgeFunction(functionName, parameters as Map<String, Any>)
+}
+
+/**
+ * Call several native functions in order with one JNI transition
+ * Called from the nativephp_call_many() PHP function via JNI. All functions
+ * are resolved under a single registry lock, then run in order.
+ * @param calls List of maps with "name" and optional "params" (or "detail",
+ *              as queued by Native::call)
+ * @return One entry per call: result or error map, null if function doesn't exist
+ */
+@Suppress("unused") // Called from JNI
+fun nativePHPCallMany(calls: List<Any?>): List<Map<String, Any>?> {
+    val entries = calls.map { it as? Map<*, *> }
+    val names = entries.map { it?.get("name") as? String }
+    val functions = BridgeFunctionRegistry.shared.getAll(names)
+
+    return entries.indices.map { i ->
+        val name = names[i]
+        val function = functions[i]
+        when {
+            name == null -> BridgeResponse.error(
+                BridgeError.InvalidParameters("call #$i has no function name")
+            )
+            function == null -> {
+                Log.e("BridgeRouter", "❌ Function '$name' not found")
+                null
+            }
+            else -> {
+                @Suppress("UNCHECKED_CAST")
+                val parameters = (entries[i]?.get("params") ?: entries[i]?.get("detail")) as? Map<String, Any>
+                runBridgeFunction(name, function, parameters ?: emptyMap())
+            }
+        }
+    }
+}
+
+/**
+ * Look up and run a bridge function, turning failures into error responses
+ * @return Response map, or null if function doesn't exist
+ */
+private fun executeBridgeFunction(functionName: String, parameters: Map<String, Any>): Map<String, Any>? {
     val function = BridgeFunctionRegistry.shared.get(functionName)
     if (function == null) {
-        Log.e("BridgeRouter", "❌ Function '$functionName' disappeared between checks")
+        Log.e("BridgeRouter", "❌ Function '$functionName' not found")
         return null
     }
 
-    // Execute the function with error handling
+    return runBridgeFunction(functionName, function, parameters)
+}
+
+/**
+ * Run an already resolved bridge function, turning failures into error responses
+ */
+private fun runBridgeFunction(
+    functionName: String,
+    function: BridgeFunction,
+    parameters: Map<String, Any>
+): Map<String, Any> {
     return try {
-        val result = function.execute(parameters)
-        val response = BridgeResponse.success(data = result)
-
-        val jsonString = BridgeResponse.toJSON(response)
-        if (jsonString != null) {
-            jsonString
-        } else {
-            val errorResponse = BridgeResponse.error(
-                code = "SERIALIZATION_ERROR",
-                message = "Failed to serialize response to JSON"
-            )
-            BridgeResponse.toJSON(errorResponse)
-        }
+        BridgeResponse.success(data = function.execute(parameters))
     } catch (error: BridgeError) {
         Log.w("BridgeRouter", "⚠️ Function '$functionName' failed: ${error.message}")
-        val response = BridgeResponse.error(error)
-        BridgeResponse.toJSON(response)
+        BridgeResponse.error(error)
     } catch (error: Exception) {
         Log.e("BridgeRouter", "❌ Function '$functionName' unexpected error: ${error.message}")
-        val response = BridgeResponse.error(
+        BridgeResponse.error(
             code = "UNKNOWN_ERROR",
             message = "Unexpected error: ${error.message}"
         )
-        BridgeResponse.toJSON(response)
     }
-}
\ No newline at end of file
+}
+
+// MARK: - Async Bridge Calls
+
+/**
+ * Runs bridge functions off the PHP thread so a request can start several
+ * slow device operations and wait for whichever finishes first.
+ *
+ * Each call gets a ticket; results are parked here until PHP collects them.
+ */
+object AsyncBridgeCalls {
+    private const val TAG = "AsyncBridgeCalls"
+
+    // Results nobody collected (e.g. the request failed) are dropped oldest first
+    private const val MAX_PARKED_RESULTS = 256
+
+    private val nextTicket = AtomicLong(1)
+    private val lock = Object()
+    private val running = HashSet<Long>()
+    private val finished = LinkedHashMap<Long, Map<String, Any>?>()
+    private val abandoned = HashSet<Long>()
+
+    private val executor = Executors.newCachedThreadPool(object : ThreadFactory {
+        private val count = AtomicInteger(1)
+        override fun newThread(r: Runnable) = Thread(r, "bridge-async-${count.getAndIncrement()}").apply {
+            isDaemon = true
+        }
+    })
+
+    /**
+     * Start [function] on the bridge executor
+     * @return Ticket to pass to [awaitAny] and [take]
+     */
+    fun submit(functionName: String, function: BridgeFunction, parameters: Map<String, Any>): Long {
+        val ticket = nextTicket.getAndIncrement()
+        synchronized(lock) { running.add(ticket) }
+
+        executor.execute {
+            val result = runBridgeFunction(functionName, function, parameters)
+            synchronized(lock) {
+                running.remove(ticket)
+                if (abandoned.remove(ticket)) return@synchronized
+                finished[ticket] = result
+                while (finished.size > MAX_PARKED_RESULTS) {
+                    val oldest = finished.keys.first()
+                    finished.remove(oldest)
+                    Log.w(TAG, "⚠️ Dropping uncollected result for ticket $oldest")
+                }
+                lock.notifyAll()
+            }
+        }
+        return ticket
+    }
+
+    /**
+     * Block until one of [tickets] has finished
+     * @param timeoutMs Give up after this long; negative waits forever
+     * @return The finished ticket, or 0 on timeout or if none is known
+     */
+    fun awaitAny(tickets: LongArray, timeoutMs: Long): Long {
+        val deadline = if (timeoutMs < 0) Long.MAX_VALUE else System.currentTimeMillis() + timeoutMs
+        synchronized(lock) {
+            while (true) {
+                tickets.firstOrNull { finished.containsKey(it) }?.let { return it }
+                if (tickets.none { running.contains(it) }) return 0
+
+                val remaining = deadline - System.currentTimeMillis()
+                if (remaining <= 0) return 0
+                lock.wait(if (timeoutMs < 0) 0 else remaining)
+            }
+        }
+    }
+
+    /**
+     * Remove and return the result of a finished ticket. A ticket that is
+     * still running is given up: its result is dropped when it arrives.
+     */
+    fun take(ticket: Long): Map<String, Any>? = synchronized(lock) {
+        if (running.contains(ticket)) {
+            abandoned.add(ticket)
+            return null
+        }
+        finished.remove(ticket)
+    }
+}
+
+/**
+ * Start a native function without waiting for it
+ * Called from the nativephp_call_async() PHP function via JNI
+ * @param functionName The fully qualified function name (e.g., "MediaLibrary.Scan")
+ * @param parameters Parameters passed from PHP
+ * @return Ticket for nativePHPAwait/nativePHPResult, or 0 if function doesn't exist
+ */
+@Suppress("unused") // Called from JNI
+fun nativePHPCallAsync(functionName: String, parameters: Map<String, Any?>): Long {
+    val function = BridgeFunctionRegistry.shared.get(functionName)
+    if (function == null) {
+        Log.e("BridgeRouter", "❌ Function '$functionName' not found")
+        return 0
+    }
+
+    @Suppress("UNCHECKED_CAST")
+    return AsyncBridgeCalls.submit(functionName, function, parameters as Map<String, Any>)
+}
+
+/**
+ * Wait until any of the given async calls has finished
+ * Called from the nativephp_await() PHP function via JNI
+ * @return The finished ticket, or 0 on timeout
+ */
+@Suppress("unused") // Called from JNI
+fun nativePHPAwait(tickets: LongArray, timeoutMs: Long): Long =
+    AsyncBridgeCalls.awaitAny(tickets, timeoutMs)
+
+/**
+ * Collect the result of a finished async call
+ * Called from the nativephp_result() PHP function via JNI
+ * @return Result or error map, or null if the ticket is unknown or still
+ *         running (a running ticket is given up)
+ */
+@Suppress("unused") // Called from JNI
+fun nativePHPResult(ticket: Long): Map<String, Any>? = AsyncBridgeCalls.take(ticket)
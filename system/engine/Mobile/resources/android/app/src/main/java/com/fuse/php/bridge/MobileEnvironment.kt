@@ -185,6 +185,9 @@ class MobileEnvironment(private val context: Context) {
 
             Log.d(TAG, "✅ Extraction complete to ${appDir.absolutePath}")
 
+            // Paths resolved against the previous bundle are stale now
+            phpBridge.invalidateAssets()
+
             // Create storage structure for hot reload/cache compatibility if needed
             val storageFramework = File(appDir, "storage/framework")
             storageFramework.mkdirs()
@@ -331,7 +334,11 @@ class MobileEnvironment(private val context: Context) {
         if (!publicDir.exists()) {
             publicDir.mkdirs()
         }
-        phpBridge.runRunnerCommand("migrate --force")
+        // One batch: every command is a request in the same engine
+        val commands = arrayOf("migrate --force")
+        phpBridge.runRunnerCommands(commands).forEachIndexed { i, output ->
+            Log.d(TAG, "🛠️ ${commands[i]}: ${output.trim()}")
+        }
     }
 
     private fun setupDirectories() {
@@ -377,6 +384,8 @@ class MobileEnvironment(private val context: Context) {
                 "CACHE_DRIVER" to "file",
                 "SESSION_DRIVER" to "file",
                 "MVC_MOBILE_PLATFORM" to "android",
+                // Boot the framework once and reuse it for every request
+                "MVC_WORKER_MODE" to "true",
                 "MVC_TEMPDIR" to context.cacheDir.absolutePath,
 
                 "COOKIE_PATH" to "/",
@@ -2,18 +2,31 @@
 
 package com.fuse.php.bridge
 
+import android.content.ComponentCallbacks2
 import android.content.Context
+import android.os.ParcelFileDescriptor
 import android.util.Log
 import android.webkit.CookieManager
-import org.json.JSONObject
+import java.io.FileInputStream
+import java.io.InputStream
+import java.nio.ByteBuffer
 import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.ExecutionException
+import java.util.concurrent.Future
+import java.util.concurrent.LinkedBlockingQueue
+import java.util.concurrent.ThreadFactory
+import java.util.concurrent.ThreadPoolExecutor
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.TimeoutException
+import java.util.concurrent.atomic.AtomicInteger
+import org.json.JSONArray
 import com.fuse.php.network.PHPRequest
 import com.fuse.php.security.MobileCookieStore
 
 class PHPBridge(private val context: Context) {
     private var lastPostData: String? = null
     private val requestDataMap = ConcurrentHashMap<String, RequestData>()
-    private val phpExecutor = java.util.concurrent.Executors.newSingleThreadExecutor()
 
     private val nativePhpScript: String
         get() = "${getAppPath()}/system/engine/Mobile/mobile_boot.php"
@@ -21,85 +34,384 @@ class PHPBridge(private val context: Context) {
     external fun nativeExecuteScript(filename: String): String
     external fun nativeSetEnv(name: String, value: String, overwrite: Int): Int
     external fun runRunnerCommand(command: String): String
+
+    /**
+     * Run runner commands in order inside the running engine, one request
+     * each; returns each command's output. Arguments may be quoted.
+     */
+    external fun runRunnerCommands(commands: Array<String>): Array<String>
     external fun initialize()
-    external fun setRequestInfo(method: String, uri: String, postData: String?, contentType: String?)
     external fun getAppPublicPath(): String
     external fun getAppPath(): String
-    external fun shutdown()
-    external fun nativeHandleRequestOnce(
-        method: String,
-        uri: String,
-        postData: String?,
-        contentType: String?,
-        scriptPath: String
-    ): String
+    external fun nativeOpenAsset(path: String): LongArray?
+    external fun nativeInvalidateAssets()
+    external fun nativeShutdown()
+    external fun nativeMaxInterpreters(): Int
+    external fun nativeMetrics(): String
+    external fun nativeRequestTrim(full: Boolean)
+    external fun nativeTrimMemory()
+    external fun nativeLastProfile(): String?
+    external fun nativeSamplerProfile(reset: Boolean): String?
+    external fun nativeHandleRequestOnce(record: ByteBuffer, length: Int): PHPResponse
+    external fun nativeHandleRequestStreaming(record: ByteBuffer, length: Int, fd: Int, sink: StreamSink)
+
+    /**
+     * Receives the response head from the interpreter thread as soon as PHP
+     * sends headers, while the body is still being written to the pipe.
+     */
+    class StreamSink {
+        private val latch = CountDownLatch(1)
+
+        @Volatile
+        private var head: PHPResponse? = null
+
+        // Called from native (send_headers or request end); the body is empty
+        fun onHead(head: PHPResponse) {
+            this.head = head
+            latch.countDown()
+        }
+
+        fun release() = latch.countDown()
+
+        // Null when the head did not arrive within timeoutMs (0 = wait forever)
+        fun await(timeoutMs: Long = 0): PHPResponse? {
+            if (timeoutMs > 0) {
+                if (!latch.await(timeoutMs, TimeUnit.MILLISECONDS)) return null
+            } else {
+                latch.await()
+            }
+            return head
+        }
+    }
+
+    /** Response head plus a body stream that fills while PHP keeps running. */
+    class StreamedResponse(val head: PHPResponse, val body: InputStream)
 
 
     companion object {
         private const val TAG = "PHPBridge"
         private const val MAX_REQUEST_AGE = 5 * 60 * 1000L
 
+        // Marks the synthetic request sent by warmUp(); see mobile_boot.php
+        private const val WARMUP_HEADER = "X-Bridge-Warmup"
+
+        // Deadline header read by the native request watchdog (bridge_watchdog.c)
+        private const val TIMEOUT_HEADER = "X-Bridge-Timeout"
+
+        // How long Kotlin keeps waiting past the deadline, for a script the
+        // watchdog can only stop once its current internal call returns
+        private const val TIMEOUT_GRACE_MS = 5_000L
+
+        @Volatile
+        private var pageTimeoutMs = 30_000L
+
+        @Volatile
+        private var actionTimeoutMs = 30_000L
+
+        /**
+         * Set the time limits the native watchdog enforces: [pageMs] for GET
+         * and HEAD navigations, [actionMs] for everything else (form posts,
+         * Fuse component actions). 0 disables the limit. A request can still
+         * carry its own X-Bridge-Timeout header, and a route can change its
+         * limit with ->timeout().
+         */
+        fun configureTimeouts(pageMs: Long, actionMs: Long) {
+            pageTimeoutMs = pageMs
+            actionTimeoutMs = actionMs
+        }
+
+        // The engine is process-wide, so one warm-up serves every PHPBridge
+        @Volatile
+        private var warmUpFuture: Future<Boolean>? = null
+
         init {
             System.loadLibrary("compat")
             System.loadLibrary("php")
             System.loadLibrary("php_wrapper")
         }
-    }
 
-    fun handleRequest(request: PHPRequest): String {
-        val requestStart = System.currentTimeMillis()
+        // Requested number of interpreter threads; 0 = pick from the CPU count
+        @Volatile
+        private var requestedPoolSize = 0
 
-        val future = phpExecutor.submit<String> {
-            val prepStart = System.currentTimeMillis()
+        @Volatile
+        private var pool: ThreadPoolExecutor? = null
 
-            var contentType: String? = null
-            request.headers.forEach { (key, value) ->
-                val envKey = "HTTP_" + key.replace("-", "_").uppercase()
-                nativeSetEnv(envKey, value, 1)
-                if (key.equals("Content-Type", ignoreCase = true)) {
-                    nativeSetEnv("CONTENT_TYPE", value, 1)
-                    contentType = value
-                }
-                if (key.equals("Content-Length", ignoreCase = true)) {
-                    nativeSetEnv("CONTENT_LENGTH", value, 1)
-                }
+        /**
+         * Set how many PHP interpreters serve requests in parallel.
+         * Must be called before the first request; the native side caps it
+         * (an NTS libphp only ever has one interpreter).
+         */
+        fun configurePool(size: Int) {
+            requestedPoolSize = size
+        }
+
+        // How long shutdown() lets queued requests finish before stopping the engine
+        private const val SHUTDOWN_WAIT_MS = 2_000L
+
+        // Shared by every PHPBridge instance: one interpreter per pool thread
+        private fun executor(bridge: PHPBridge): ThreadPoolExecutor {
+            pool?.let { return it }
+            return synchronized(this) {
+                pool ?: createPool(bridge).also { pool = it }
             }
+        }
 
-            val cookieHeader = MobileCookieStore.asCookieHeader()
-            nativeSetEnv("HTTP_COOKIE", cookieHeader, 1)
+        // Detach the pool so the next request starts a new one; null when none was started
+        private fun takePool(): ThreadPoolExecutor? = synchronized(this) {
+            pool.also { pool = null }
+        }
 
-            Log.d(TAG, "🍪 Sent HTTP_COOKIE to native: $cookieHeader")
+        private fun createPool(bridge: PHPBridge): ThreadPoolExecutor {
+            val cores = Runtime.getRuntime().availableProcessors()
+            val wanted = if (requestedPoolSize > 0) requestedPoolSize else (cores / 2).coerceIn(1, 4)
+            val size = wanted.coerceAtMost(bridge.nativeMaxInterpreters()).coerceAtLeast(1)
+            Log.d(TAG, "🧵 PHP interpreter pool: $size thread(s) (requested=$wanted, cores=$cores)")
 
-            initialize()
+            val counter = AtomicInteger()
+            val factory = ThreadFactory { runnable ->
+                Thread(runnable, "php-interpreter-${counter.incrementAndGet()}")
+            }
+            return ThreadPoolExecutor(size, size, 0L, TimeUnit.MILLISECONDS, LinkedBlockingQueue(), factory)
+        }
+    }
+
+    /**
+     * Start the engine and boot the framework ahead of the first navigation.
+     *
+     * Queues a synthetic request on the interpreter pool. mobile_boot.php
+     * recognises it, loads Bootstrap, routes and the hot classes without
+     * dispatching, and (in worker mode) leaves the worker resident. Requests
+     * submitted afterwards queue behind it and find a hot runtime. Safe to call
+     * more than once; [onReady] runs on the interpreter thread with whether
+     * the boot succeeded.
+     */
+    fun warmUp(onReady: ((Boolean) -> Unit)? = null): Future<Boolean> {
+        val future = synchronized(PHPBridge::class.java) {
+            warmUpFuture ?: executor(this).submit<Boolean> {
+                val start = System.currentTimeMillis()
+                val ok = try {
+                    val request = PHPRequest(url = "/", headers = mapOf(WARMUP_HEADER to "1"))
+                    val record = prepareRequest(request)
+                    val response = nativeHandleRequestOnce(record, record.position())
+
+                    // Bootstrap may have started the session; the first real request must reuse it
+                    applySetCookies(response)
+                    response.status < 500
+                } catch (e: Exception) {
+                    Log.e(TAG, "❌ Engine warm-up failed", e)
+                    false
+                }
+                Log.d("PerfTiming", "⏱️ WARMUP ok=$ok ${System.currentTimeMillis() - start}ms")
+                ok
+            }.also { warmUpFuture = it }
+        }
+
+        if (onReady != null) {
+            executor(this).execute { onReady(runCatching { future.get() }.getOrDefault(false)) }
+        }
+        return future
+    }
+
+    fun handleRequest(request: PHPRequest): PHPResponse {
+        val requestStart = System.currentTimeMillis()
+
+        val future = executor(this).submit<PHPResponse> {
+            val prepStart = System.currentTimeMillis()
+
+            val record = prepareRequest(request)
 
             val prepTime = System.currentTimeMillis() - prepStart
             val jniStart = System.currentTimeMillis()
 
-            val output = nativeHandleRequestOnce(
-                request.method,
-                request.uri,
-                request.body,
-                contentType,
-                nativePhpScript
-            )
+            val response = nativeHandleRequestOnce(record, record.position())
 
             val jniTime = System.currentTimeMillis() - jniStart
-            val processStart = System.currentTimeMillis()
-
-            val processedOutput = processRawPHPResponse(output)
-
-            val processTime = System.currentTimeMillis() - processStart
-            Log.d("PerfTiming", "⏱️ BRIDGE [${request.uri}] prep=${prepTime}ms jni=${jniTime}ms process=${processTime}ms")
+            Log.d("PerfTiming", "⏱️ BRIDGE [${request.uri}] prep=${prepTime}ms jni=${jniTime}ms (${response.header("Server-Timing")})")
 
-            processedOutput
+            applySetCookies(response)
+            response
         }
 
-        val result = future.get()
+        val timeoutMs = timeoutFor(request)
+        val result = try {
+            if (timeoutMs > 0) future.get(timeoutMs + TIMEOUT_GRACE_MS, TimeUnit.MILLISECONDS) else future.get()
+        } catch (e: TimeoutException) {
+            Log.e(TAG, "⏰ No response for ${request.uri} after ${timeoutMs + TIMEOUT_GRACE_MS}ms, interpreter still busy")
+            PHPResponse.error(503, "Service Unavailable", "Request timed out: ${request.method} ${request.uri}")
+        } catch (e: ExecutionException) {
+            Log.e(TAG, "❌ Request failed: ${request.uri}", e.cause ?: e)
+            PHPResponse.error(500, "Internal Server Error", "Request failed: ${request.method} ${request.uri}")
+        }
         val totalTime = System.currentTimeMillis() - requestStart
         Log.d("PerfTiming", "⏱️ BRIDGE_TOTAL [${request.uri}] ${totalTime}ms")
         return result
     }
 
+    /**
+     * Stop the engine. The interpreter pool is drained first and its threads
+     * exit, so each one stops its own resident worker and frees its
+     * interpreter on that thread; module shutdown runs afterwards. The next
+     * request starts a new pool and engine.
+     */
+    fun shutdown() {
+        synchronized(PHPBridge::class.java) {
+            warmUpFuture = null
+        }
+        takePool()?.let { pool ->
+            pool.shutdown()
+            if (!pool.awaitTermination(SHUTDOWN_WAIT_MS, TimeUnit.MILLISECONDS)) {
+                Log.e(TAG, "⏰ Interpreter pool still busy after ${SHUTDOWN_WAIT_MS}ms, shutting down anyway")
+            }
+        }
+        nativeShutdown()
+    }
+
+    /** A static file opened by the native asset resolver; the caller closes [stream]. */
+    class Asset(val stream: FileInputStream, val size: Long, val lastModified: Long)
+
+    /**
+     * Open the static file for [path] (relative to public/, no query string)
+     * from public/, public/vendor/, public/build/ or persisted storage/. The
+     * resolved location of each path, and each miss, is cached natively.
+     * Null when no file matches and the request should go to PHP.
+     */
+    fun openAsset(path: String): Asset? {
+        val info = nativeOpenAsset(path) ?: return null
+        val fd = ParcelFileDescriptor.adoptFd(info[0].toInt())
+        return Asset(ParcelFileDescriptor.AutoCloseInputStream(fd), info[1], info[2])
+    }
+
+    /** Drop cached asset paths, e.g. after a new app bundle was extracted. */
+    fun invalidateAssets() = nativeInvalidateAssets()
+
+    /**
+     * Release memory held by the PHP interpreters; called from onTrimMemory.
+     * Every interpreter compacts its own Zend heap and response buffers. From
+     * TRIM_MEMORY_UI_HIDDEN up (app in the background), a resident worker
+     * also collects garbage cycles first. Idle interpreters trim in tasks
+     * posted to the pool; one busy with a request trims right after it.
+     * Nothing here waits.
+     */
+    fun trimMemory(level: Int) {
+        val pool = pool ?: return
+        nativeRequestTrim(level >= ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN)
+        repeat(pool.corePoolSize) {
+            pool.execute { nativeTrimMemory() }
+        }
+    }
+
+    /**
+     * Phase timing and memory of the most recent requests (oldest first), as
+     * recorded by the native bridge. Each entry has method, uri, status,
+     * worker, startup_ms, globals_ms, compile_ms, execute_ms, output_ms,
+     * shutdown_ms, total_ms, peak_memory, heap_size and bytes_out.
+     */
+    fun metrics(): JSONArray = JSONArray(nativeMetrics())
+
+    /**
+     * Turn on the native function profiler. It records call counts and
+     * inclusive/exclusive time per PHP function and writes one folded-stack
+     * file per request into [outputDir], ready for flamegraph.pl or speedscope.
+     * The observer hooks are installed at engine startup, so call this before
+     * the first request (or before a shutdown()/restart). It slows PHP down,
+     * so keep it to profiling builds.
+     */
+    fun enableProfiler(outputDir: java.io.File) {
+        outputDir.mkdirs()
+        nativeSetEnv("MVC_PROFILER", "1", 1)
+        nativeSetEnv("MVC_PROFILER_DIR", outputDir.absolutePath, 1)
+    }
+
+    /** Folded stacks of the most recently profiled request, or null. */
+    fun lastProfile(): String? = nativeLastProfile()
+
+    /**
+     * Turn on the sampling profiler: every [intervalMs] the running PHP stack
+     * of each busy interpreter is sampled and counted per route. Its overhead
+     * is low enough for beta builds. Like enableProfiler(), it takes effect at
+     * the next engine start.
+     */
+    fun enableSampler(intervalMs: Int = 10) {
+        nativeSetEnv("MVC_SAMPLER", "1", 1)
+        nativeSetEnv("MVC_SAMPLER_INTERVAL_MS", intervalMs.toString(), 1)
+    }
+
+    /**
+     * Sampled stacks since the engine started (or the last reset) as folded
+     * lines "GET:/route;frame;...;frame count", or null when the sampler is off.
+     */
+    fun samplerProfile(reset: Boolean = false): String? = nativeSamplerProfile(reset)
+
+    // Watchdog limit for [request]: its own X-Bridge-Timeout, else by request type
+    private fun timeoutFor(request: PHPRequest): Long {
+        request.headers.entries.firstOrNull { it.key.equals(TIMEOUT_HEADER, ignoreCase = true) }?.let {
+            return it.value.trim().toLongOrNull() ?: pageTimeoutMs
+        }
+        val method = request.method.uppercase()
+        return if (method == "GET" || method == "HEAD") pageTimeoutMs else actionTimeoutMs
+    }
+
+    // Pack the request (headers plus the bridge cookie jar) into this thread's
+    // request record; native starts the engine itself on first use
+    private fun prepareRequest(request: PHPRequest): ByteBuffer {
+        val names = ArrayList<String>(request.headers.size + 2)
+        val values = ArrayList<String>(request.headers.size + 2)
+        request.headers.forEach { (key, value) ->
+            if (!key.equals("Cookie", ignoreCase = true)) {
+                names.add(key)
+                values.add(value)
+            }
+        }
+
+        if (request.headers.keys.none { it.equals(TIMEOUT_HEADER, ignoreCase = true) }) {
+            names.add(TIMEOUT_HEADER)
+            values.add(timeoutFor(request).toString())
+        }
+
+        val cookieHeader = MobileCookieStore.asCookieHeader()
+        names.add("Cookie")
+        values.add(cookieHeader)
+
+        return RequestRecord.encode(request, nativePhpScript, names.toTypedArray(), values.toTypedArray())
+    }
+
+    /**
+     * Run a request in streaming mode: returns as soon as PHP has sent its
+     * headers, with a body stream backed by a pipe the interpreter writes into.
+     */
+    fun handleRequestStreaming(request: PHPRequest): StreamedResponse {
+        val requestStart = System.currentTimeMillis()
+        val (readSide, writeSide) = ParcelFileDescriptor.createPipe()
+        val sink = StreamSink()
+
+        executor(this).execute {
+            var fd = -1
+            try {
+                val record = prepareRequest(request)
+                fd = writeSide.detachFd()
+
+                // Native owns the write end from here and closes it when PHP is done
+                nativeHandleRequestStreaming(record, record.position(), fd, sink)
+            } catch (e: Exception) {
+                Log.e(TAG, "❌ Streaming request failed: ${request.uri}", e)
+                if (fd < 0) writeSide.close()
+            } finally {
+                sink.release()
+            }
+        }
+
+        val timeoutMs = timeoutFor(request)
+        val head = sink.await(if (timeoutMs > 0) timeoutMs + TIMEOUT_GRACE_MS else 0)
+            ?: PHPResponse.error(503, "Service Unavailable", "")
+
+        val ttfb = System.currentTimeMillis() - requestStart
+        Log.d("PerfTiming", "⏱️ BRIDGE_TTFB [${request.uri}] ${ttfb}ms")
+
+        applySetCookies(head)
+        return StreamedResponse(head, ParcelFileDescriptor.AutoCloseInputStream(readSide))
+    }
+
     // New function to store request data with a key
     fun storeRequestData(url: String, data: String, headers: String? = null) {
         // Store by URL to ensure we get the correct body for the correct request
@@ -167,85 +479,18 @@ class PHPBridge(private val context: Context) {
     }
 
 
-    fun processRawPHPResponse(response: String): String {
-        // Log the first 200 characters to understand the response format
-        Log.d(TAG, "🔍 Response first 200 chars: ${response.take(200)}")
-
-        // Check for Set-Cookie headers regardless of response format
-        if (response.contains("Set-Cookie:", ignoreCase = true)) {
-            Log.d(TAG, "🍪 Found Set-Cookie in raw response!")
-
-            // Extract all Set-Cookie lines
-            val setCookieLines = response.split("\r\n")
-                .filter { it.startsWith("Set-Cookie:", ignoreCase = true) }
-
-            setCookieLines.forEach { cookieLine ->
-                Log.d(TAG, "🍪 Cookie line: $cookieLine")
-
-                // Extract the cookie value (after "Set-Cookie:")
-                val cookieValue = cookieLine.substringAfter(":", "").trim()
-                if (cookieValue.isNotEmpty()) {
-                    // Manually set this cookie
-                    val cookieManager = CookieManager.getInstance()
-                    cookieManager.setCookie("http://127.0.0.1", cookieValue)
-
-                    // Also store in MobileCookieStore to ensure persistence across bridge calls
-                    //MobileCookieStore.storeFromSetCookieHeader(cookieValue)
-
-                    Log.d(TAG, "🍪 Manually set cookie: $cookieValue")
-                }
-            }
+    // Hand every Set-Cookie from the response to the WebView and the bridge cookie jar
+    private fun applySetCookies(response: PHPResponse) {
+        val cookies = response.headers("Set-Cookie")
+        if (cookies.isEmpty()) return
 
-            // Make sure to flush the cookies
-            CookieManager.getInstance().flush()
-            Log.d(TAG, "🍪 Flushed cookies after extraction")
-        } else {
-            Log.d(TAG, "⚠️ No Set-Cookie headers found in the response")
+        val cookieManager = CookieManager.getInstance()
+        cookies.forEach { cookie ->
+            MobileCookieStore.storeFromSetCookieHeader(cookie)
+            cookieManager.setCookie("http://127.0.0.1", cookie)
+            Log.d(TAG, "🍪 Stored cookie ${cookie.substringBefore('=').trim()} from Set-Cookie header")
         }
-
-        // Continue with your existing logic for different response types
-        if (response.trim().startsWith("{") && response.trim().endsWith("}")) {
-            try {
-                val json = JSONObject(response)
-                if (json.has("message") && json.getString("message")
-                        .contains("CSRF token mismatch")
-                ) {
-                    Log.e(TAG, "CSRF token mismatch detected. Adding 419 status.")
-                    return "HTTP/1.1 419 Page Expired\r\n" +
-                            "Content-Type: application/json\r\n" +
-                            "X-CSRF-Error: true\r\n" +
-                            "\r\n" +
-                            response
-                }
-
-                // Regular JSON response
-                return "HTTP/1.1 200 OK\r\n" +
-                        "Content-Type: application/json\r\n" +
-                        "\r\n" +
-                        response
-            } catch (e: Exception) {
-                Log.e(TAG, "Error parsing JSON response", e)
-            }
-        }
-
-        // If it already has headers (check for common header fields)
-        if (response.contains("Content-Type:", ignoreCase = true) ||
-            response.contains("Set-Cookie:", ignoreCase = true)
-        ) {
-
-            // It has some headers, but might not have the status line
-            // Add a status line if it doesn't have one
-            if (!response.startsWith("HTTP/")) {
-                return "HTTP/1.1 200 OK\r\n" + response
-            }
-            return response
-        }
-
-        // Default case: assume it's just content without headers
-        return "HTTP/1.1 200 OK\r\n" +
-                "Content-Type: text/html\r\n" +
-                "\r\n" +
-                response
+        cookieManager.flush()
     }
 
     // All native bridge methods have been migrated to god method pattern
@@ -0,0 +1,97 @@
+package com.fuse.php.bridge
+
+import android.os.ParcelFileDescriptor
+import com.fuse.php.network.ByteRange
+import java.io.ByteArrayInputStream
+import java.io.InputStream
+
+/**
+ * A PHP response as produced by the native bridge: the final status and
+ * header list captured from SAPI at send_headers, plus the raw body.
+ *
+ * Headers arrive as parallel name/value arrays in the order PHP sent them,
+ * so reading one never touches the body. Built from JNI, see
+ * build_response() in php_bridge.c.
+ *
+ * A file response (X-Sendfile) has an empty [body]; the bridge passes the
+ * open file instead as [fileFd] plus the slice to send. [bodyStream] takes
+ * ownership of that descriptor.
+ */
+class PHPResponse(
+    val status: Int,
+    val reason: String,
+    val headerNames: Array<String>,
+    val headerValues: Array<String>,
+    val body: ByteArray,
+    private val fileFd: Int = -1,
+    private val fileOffset: Long = 0,
+    private val fileLength: Long = 0
+) {
+    /**
+     * The response body: the file slice read straight from disk for a file
+     * response, else [body]. Call it once; the caller closes the stream.
+     */
+    fun bodyStream(): InputStream {
+        if (fileFd < 0) return ByteArrayInputStream(body)
+        val file = ParcelFileDescriptor.AutoCloseInputStream(ParcelFileDescriptor.adoptFd(fileFd))
+        return ByteRange(fileOffset, fileOffset + fileLength - 1).slice(file)
+    }
+
+    /** First value of header [name] (case-insensitive), or null. */
+    fun header(name: String): String? {
+        for (i in headerNames.indices) {
+            if (headerNames[i].equals(name, ignoreCase = true)) return headerValues[i]
+        }
+        return null
+    }
+
+    /** Every value of header [name] (case-insensitive), e.g. all Set-Cookie lines. */
+    fun headers(name: String): List<String> {
+        val values = ArrayList<String>(1)
+        for (i in headerNames.indices) {
+            if (headerNames[i].equals(name, ignoreCase = true)) values.add(headerValues[i])
+        }
+        return values
+    }
+
+    /** Mime type part of Content-Type, without parameters. */
+    val mimeType: String?
+        get() = header("Content-Type")?.substringBefore(';')?.trim()?.ifEmpty { null }
+
+    /** charset parameter of Content-Type, or null. */
+    val charset: String?
+        get() = header("Content-Type")
+            ?.split(';')
+            ?.drop(1)
+            ?.map { it.trim() }
+            ?.firstOrNull { it.startsWith("charset=", ignoreCase = true) }
+            ?.substringAfter('=')
+            ?.trim('"', ' ')
+
+    /**
+     * Headers as a map for WebResourceResponse. Repeated headers keep the
+     * last value, except Set-Cookie whose values are joined with newlines.
+     */
+    fun headerMap(): MutableMap<String, String> {
+        val map = LinkedHashMap<String, String>(headerNames.size)
+        for (i in headerNames.indices) {
+            val name = headerNames[i]
+            if (name.equals("Set-Cookie", ignoreCase = true)) {
+                map.merge(name, headerValues[i]) { old, new -> "$old\n$new" }
+            } else {
+                map[name] = headerValues[i]
+            }
+        }
+        return map
+    }
+
+    companion object {
+        fun error(status: Int, reason: String, message: String) = PHPResponse(
+            status,
+            reason,
+            arrayOf("Content-Type"),
+            arrayOf("text/plain"),
+            message.toByteArray()
+        )
+    }
+}
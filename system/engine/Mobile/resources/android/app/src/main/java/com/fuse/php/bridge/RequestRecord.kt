@@ -0,0 +1,82 @@
+package com.fuse.php.bridge
+
+import com.fuse.php.network.PHPRequest
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Packs a request into one direct ByteBuffer so the native bridge can read
+ * every field straight from memory instead of making a JNI call per string.
+ *
+ * Layout (native byte order, every string UTF-8 and followed by a NUL so C
+ * can point into the buffer without copying):
+ *
+ *   u32 version
+ *   str method, str uri, str scriptPath
+ *   u32 headerCount, then headerCount × (str name, str value)
+ *   str body
+ *
+ * where str = u32 byteLength + bytes + NUL. Must match request_decode() in php_bridge.c.
+ */
+object RequestRecord {
+    const val VERSION = 1
+
+    private const val INITIAL_CAPACITY = 16 * 1024
+
+    // One reusable buffer per interpreter thread
+    private val buffers = object : ThreadLocal<ByteBuffer>() {
+        override fun initialValue(): ByteBuffer = allocate(INITIAL_CAPACITY)
+    }
+
+    private fun allocate(capacity: Int): ByteBuffer =
+        ByteBuffer.allocateDirect(capacity).order(ByteOrder.nativeOrder())
+
+    /**
+     * Encode [request] into this thread's buffer. The returned buffer's
+     * position is the record length; it is only valid until the next call
+     * on the same thread.
+     */
+    fun encode(
+        request: PHPRequest,
+        scriptPath: String,
+        headerNames: Array<String>,
+        headerValues: Array<String>
+    ): ByteBuffer {
+        val method = request.method.toByteArray(Charsets.UTF_8)
+        val uri = request.uri.toByteArray(Charsets.UTF_8)
+        val script = scriptPath.toByteArray(Charsets.UTF_8)
+        val body = request.body.toByteArray(Charsets.UTF_8)
+        val names = Array(headerNames.size) { headerNames[it].toByteArray(Charsets.UTF_8) }
+        val values = Array(headerValues.size) { headerValues[it].toByteArray(Charsets.UTF_8) }
+
+        var size = 4 + sized(method) + sized(uri) + sized(script) + 4 + sized(body)
+        for (i in names.indices) size += sized(names[i]) + sized(values[i])
+
+        var buffer = buffers.get()!!
+        if (buffer.capacity() < size) {
+            buffer = allocate(Integer.highestOneBit(size) shl 1)
+            buffers.set(buffer)
+        }
+
+        buffer.clear()
+        buffer.putInt(VERSION)
+        putString(buffer, method)
+        putString(buffer, uri)
+        putString(buffer, script)
+        buffer.putInt(names.size)
+        for (i in names.indices) {
+            putString(buffer, names[i])
+            putString(buffer, values[i])
+        }
+        putString(buffer, body)
+        return buffer
+    }
+
+    private fun sized(bytes: ByteArray) = 4 + bytes.size + 1
+
+    private fun putString(buffer: ByteBuffer, bytes: ByteArray) {
+        buffer.putInt(bytes.size)
+        buffer.put(bytes)
+        buffer.put(0)
+    }
+}
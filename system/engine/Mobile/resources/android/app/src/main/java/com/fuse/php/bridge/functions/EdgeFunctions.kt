@@ -16,11 +16,11 @@ object EdgeFunctions {
      *   - components: array - Array of Edge components
      *
      * Usage Example:
-     *   nativephp_call('Edge.Set', json_encode([
+     *   nativephp_call('Edge.Set', [
      *     'components' => [
      *       ['type' => 'bottom_nav', 'data' => [...]]
      *     ]
-     *   ]));
+     *   ]);
      */
     class Set : BridgeFunction {
         override fun execute(parameters: Map<String, Any>): Map<String, Any> {
@@ -0,0 +1,74 @@
+package com.fuse.php.network
+
+import java.io.FileInputStream
+import java.io.FilterInputStream
+import java.io.InputStream
+
+/**
+ * A single "Range: bytes=" request resolved against a file of a known size,
+ * as served by PHPWebViewClient.handleAssetRequest(). Mirrors
+ * Engine\Http\Response::parseRange() on the PHP side.
+ */
+class ByteRange(val start: Long, val endInclusive: Long) {
+    val length: Long
+        get() = endInclusive - start + 1
+
+    fun contentRange(size: Long) = "bytes $start-$endInclusive/$size"
+
+    /**
+     * [file] positioned at [start] and cut off after [length] bytes. Seeks
+     * the underlying descriptor, so nothing before the range is read.
+     */
+    fun slice(file: FileInputStream): InputStream {
+        file.channel.position(start)
+        return object : FilterInputStream(file) {
+            private var remaining = length
+
+            override fun read(): Int {
+                if (remaining <= 0) return -1
+                val b = super.read()
+                if (b >= 0) remaining--
+                return b
+            }
+
+            override fun read(buffer: ByteArray, offset: Int, count: Int): Int {
+                if (remaining <= 0) return -1
+                val n = super.read(buffer, offset, minOf(count.toLong(), remaining).toInt())
+                if (n > 0) remaining -= n
+                return n
+            }
+
+            override fun available(): Int = minOf(super.available().toLong(), remaining).toInt()
+        }
+    }
+
+    companion object {
+        /** Returned by [parse] when the range lies outside the file (416). */
+        val UNSATISFIABLE = ByteRange(-1, -2)
+
+        private val PATTERN = Regex("""^\s*bytes\s*=\s*(\d*)\s*-\s*(\d*)\s*$""", RegexOption.IGNORE_CASE)
+
+        /**
+         * Resolve [header] against [size]. Null when there is no header or
+         * it is one we ignore (several ranges, other units, malformed), in
+         * which case the whole file is sent with 200.
+         */
+        fun parse(header: String?, size: Long): ByteRange? {
+            val match = header?.let { PATTERN.matchEntire(it) } ?: return null
+            val (first, last) = match.destructured
+            if (first.isEmpty() && last.isEmpty()) return null
+
+            if (first.isEmpty()) {
+                // Suffix range: the last N bytes
+                val suffix = last.toLongOrNull() ?: return null
+                return if (suffix > 0 && size > 0) ByteRange(maxOf(0, size - suffix), size - 1) else UNSATISFIABLE
+            }
+
+            val start = first.toLongOrNull() ?: return null
+            val end = if (last.isEmpty()) size - 1 else (last.toLongOrNull() ?: return null)
+            if (end < start) return null
+            if (start >= size) return UNSATISFIABLE
+            return ByteRange(start, minOf(end, size - 1))
+        }
+    }
+}
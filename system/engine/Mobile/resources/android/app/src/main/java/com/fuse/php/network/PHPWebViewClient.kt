@@ -5,7 +5,6 @@ import android.webkit.*
 import java.io.ByteArrayInputStream
 import java.io.BufferedInputStream
 import android.content.Context
-import java.io.File
 import android.net.Uri
 import com.fuse.php.bridge.PHPBridge
 import com.fuse.php.bridge.RequestData
@@ -46,37 +45,15 @@ class PHPWebViewClient(
         Log.d(TAG, "🗂️ Handling asset request: $path")
 
         return try {
-            // Get App public path
-            val appPublicPath = phpBridge.getAppPublicPath()
-            val appStorageDir = File(context.filesDir.parent, "app_storage")
-            val storageRoot = File(appStorageDir, "persisted_data/storage")
-            val storageCandidate = if (cleanPath.startsWith("storage/")) {
-                File(storageRoot, cleanPath.removePrefix("storage/")).absolutePath
-            } else {
-                null
-            }
-
-            // Try multiple possible locations for the asset
-            val possiblePaths = listOf(
-                "$appPublicPath/$path",                // Direct path with query
-                "$appPublicPath/$cleanPath",           // Direct path without query
-                "$appPublicPath/vendor/$cleanPath",    // Vendor path
-                "$appPublicPath/build/$cleanPath",      // Build path
-                storageCandidate ?: ""                  // App storage persisted files (e.g., /storage/app/...)
-            )
-
-            // Log all paths we're trying
-            Log.d(TAG, "🔍 Checking paths: ${possiblePaths.joinToString()}")
-
-            // Try each path
-            val assetFile = possiblePaths.firstOrNull { it.isNotBlank() && File(it).exists() }?.let { File(it) }
+            // Resolved natively: cached roots and path lookups, one open() per hit
+            val asset = phpBridge.openAsset(cleanPath)
 
-            if (assetFile != null && assetFile.exists()) {
-                Log.d(TAG, "✅ Found asset at: ${assetFile.absolutePath}")
+            if (asset != null) {
+                Log.d(TAG, "✅ Found asset: $cleanPath (${asset.size} bytes)")
 
                 // Determine MIME type
                 val mimeType = guessMimeType(cleanPath)
-                val fileSize = assetFile.length()
+                val fileSize = asset.size
 
                 // Create appropriate response headers
                 val responseHeaders = mutableMapOf<String, String>()
@@ -105,18 +82,37 @@ class PHPWebViewClient(
                 }
 
                 Log.d(TAG, "📋 Serving with MIME type: ${responseHeaders["Content-Type"]}")
-                responseHeaders["Content-Length"] = fileSize.toString()
+                responseHeaders["Accept-Ranges"] = "bytes"
+
+                // <video>/<audio> seek with Range requests; answer them from the fd
+                val range = ByteRange.parse(headerValue(requestHeaders, "Range"), fileSize)
+                if (range === ByteRange.UNSATISFIABLE) {
+                    asset.stream.close()
+                    responseHeaders["Content-Range"] = "bytes */$fileSize"
+                    responseHeaders["Content-Length"] = "0"
+                    return WebResourceResponse(
+                        responseHeaders["Content-Type"], "UTF-8", 416, "Range Not Satisfiable",
+                        responseHeaders, ByteArrayInputStream(ByteArray(0))
+                    )
+                }
 
-                // Use BufferedInputStream with 1MB buffer for efficient streaming (matching iOS)
-                // Note: We don't advertise Accept-Ranges because the stream doesn't support true seeking
-                // Android WebView handles progressive loading internally
-                val bufferedStream = BufferedInputStream(assetFile.inputStream(), 1024 * 1024)
+                // Read straight from the file descriptor the resolver opened
+                val body = if (range != null) {
+                    Log.d(TAG, "📋 Serving range ${range.contentRange(fileSize)}")
+                    responseHeaders["Content-Range"] = range.contentRange(fileSize)
+                    responseHeaders["Content-Length"] = range.length.toString()
+                    range.slice(asset.stream)
+                } else {
+                    responseHeaders["Content-Length"] = fileSize.toString()
+                    asset.stream
+                }
+                val bufferedStream = BufferedInputStream(body, 64 * 1024)
 
                 WebResourceResponse(
                     responseHeaders["Content-Type"] ?: "application/octet-stream",
                     "UTF-8",
-                    200,
-                    "OK",
+                    if (range != null) 206 else 200,
+                    if (range != null) "Partial Content" else "OK",
                     responseHeaders,
                     bufferedStream
                 )
@@ -129,26 +125,28 @@ class PHPWebViewClient(
                     url = "/$path",
                     method = "GET",
                     body = "",
-                    headers = mapOf("Accept" to "*/*"),
+                    headers = listOfNotNull(
+                        "Accept" to "*/*",
+                        headerValue(requestHeaders, "Range")?.let { "Range" to it }
+                    ).toMap(),
                     getParameters = emptyMap()
                 )
 
                 val response = phpBridge.handleRequest(phpRequest)
-                val (responseHeaders, body, statusCode) = parseResponse(response)
-                Log.d(TAG, "RESPONSE HEADERS: ${responseHeaders}")
 
-                if (statusCode == 200) {
-                    Log.d(TAG, "✅ Asset served via PHP: ${responseHeaders["Content-Type"]}")
+                // Response::stream() answers a forwarded Range with 206
+                if (response.status == 200 || response.status == 206) {
+                    Log.d(TAG, "✅ Asset served via PHP: ${response.mimeType}")
                     WebResourceResponse(
-                        responseHeaders["Content-Type"] ?: guessMimeType(cleanPath),
-                        responseHeaders["Charset"] ?: "UTF-8",
-                        statusCode,
-                        "OK",
-                        responseHeaders,
-                        body.byteInputStream()
+                        response.mimeType ?: guessMimeType(cleanPath),
+                        response.charset ?: "UTF-8",
+                        response.status,
+                        response.reason,
+                        response.headerMap(),
+                        response.bodyStream()
                     )
                 } else {
-                    Log.d(TAG, "❌ Asset not found via PHP: $path (Status: $statusCode)")
+                    Log.d(TAG, "❌ Asset not found via PHP: $path (Status: ${response.status})")
                     errorResponse(404, "Asset not found: $path")
                 }
             }
@@ -218,31 +216,26 @@ class PHPWebViewClient(
         val prepTime = System.currentTimeMillis() - requestStart
         val phpStart = System.currentTimeMillis()
 
-        val response = phpBridge.handleRequest(phpRequest)
+        // Stream the body: the WebView starts reading as soon as PHP sends headers
+        val streamed = phpBridge.handleRequestStreaming(phpRequest)
 
         val phpTime = System.currentTimeMillis() - phpStart
-        val parseStart = System.currentTimeMillis()
-
-        val (responseHeaders, body, statusCode) = parseResponse(response)
-
-        val parseTime = System.currentTimeMillis() - parseStart
-        Log.d("PerfTiming", "⏱️ WEBCLIENT [$path] prep=${prepTime}ms php=${phpTime}ms parse=${parseTime}ms")
-
-        // ✅ Handle Set-Cookie headers
-        responseHeaders.entries
-            .filter { it.key.equals("Set-Cookie", ignoreCase = true) }
-            .forEach { (_, value) ->
-                Log.d(TAG, "🍪 Setting cookie from response: $value")
-                CookieManager.getInstance().setCookie("http://127.0.0.1", value)
-            }
-
-        CookieManager.getInstance().flush()
+        Log.d("PerfTiming", "⏱️ WEBCLIENT [$path] prep=${prepTime}ms php=${phpTime}ms")
+
+        // Set-Cookie headers were already applied by the bridge
+        val head = streamed.head
+        val body = streamed.body
+        val statusCode = head.status
+        head.header("X-PHP-Timing")?.let { timing ->
+            Log.d("PerfTiming", "⏱️ PHP_TIMING $timing")
+        }
 
         // ✅ Handle redirects
         if (statusCode in 300..399) {
-            val location = responseHeaders["Location"] ?: responseHeaders["location"]
+            val location = head.header("Location")
             if (!location.isNullOrEmpty()) {
                 Log.d(TAG, "🔄 Intercepting redirect to $location")
+                body.close()
 
                 var targetUrl = location
                 // If it's an absolute URL pointing to localhost/127.0.0.1, convert to relative path
@@ -278,9 +271,8 @@ class PHPWebViewClient(
                 """.trimIndent()
 
                 // Remove Location header to prevent confusion (since we are returning 200 OK with meta refresh)
-                val newHeaders = HashMap(responseHeaders)
-                newHeaders.remove("Location")
-                newHeaders.remove("location")
+                val newHeaders = head.headerMap()
+                newHeaders.keys.removeAll { it.equals("Location", ignoreCase = true) || it.equals("Content-Type", ignoreCase = true) }
                 newHeaders["Content-Type"] = "text/html"
 
                 return WebResourceResponse(
@@ -294,99 +286,37 @@ class PHPWebViewClient(
             }
         }
 
+        // ✅ Not modified: WebResourceResponse rejects 3xx codes, so fuse.js
+        // gets the 304 as an empty 204 flagged with X-Bridge-Not-Modified
+        if (statusCode == 304) {
+            body.close()
+            val notModifiedHeaders = head.headerMap()
+            notModifiedHeaders["X-Bridge-Not-Modified"] = "1"
+            return WebResourceResponse(
+                head.mimeType ?: "text/html",
+                head.charset ?: "UTF-8",
+                204,
+                "No Content",
+                notModifiedHeaders,
+                ByteArrayInputStream(ByteArray(0))
+            )
+        }
+
         // ✅ Normal response
         return WebResourceResponse(
-            responseHeaders["Content-Type"] ?: "text/html",
-            responseHeaders["Charset"] ?: "UTF-8",
+            head.mimeType ?: "text/html",
+            head.charset ?: "UTF-8",
             statusCode,
-            if (statusCode == 200) "OK" else "Error",
-            responseHeaders,
-            body.byteInputStream()
+            head.reason,
+            head.headerMap(),
+            body
         )
     }
 
-   fun parseResponse(rawResponse: String): Triple<Map<String, String>, String, Int> {
-       val headers = mutableMapOf<String, String>()
-       var statusCode = 200
-       var body = ""
-
-       val parts = rawResponse.split(Regex("\\r?\\n\\r?\\n"), limit = 2)
-       if (parts.size < 2) {
-           val idx = rawResponse.indexOf("\n\n")
-           if (idx >= 0) {
-               val head = rawResponse.substring(0, idx)
-               val b = rawResponse.substring(idx + 2)
-               val headerLinesFallback = head.split(Regex("\\r?\\n"))
-               parseHeaders(headerLinesFallback, headers)?.let { statusCode = it }
-               body = b
-           } else {
-               return Triple(headers, rawResponse.trim(), statusCode)
-           }
-       } else {
-           val headerLines = parts[0].split(Regex("\\r?\\n"))
-           parseHeaders(headerLines, headers)?.let { statusCode = it }
-           body = parts[1]
-       }
-
-       val cleanedBody = run {
-           val bodyParts = body.split(Regex("\\r?\\n\\r?\\n"), limit = 2)
-           val firstLine = body.lineSequence().firstOrNull() ?: ""
-           val looksLikeStatus = firstLine.startsWith("HTTP/")
-           val looksLikeHeaderBlock = firstLine.startsWith("X-Powered-By:", true) ||
-                   firstLine.startsWith("Cache-Control:", true) ||
-                   firstLine.startsWith("Pragma:", true) ||
-                   firstLine.startsWith("Expires:", true)
-           if (bodyParts.size == 2 && (looksLikeStatus || looksLikeHeaderBlock)) bodyParts[1] else body
-       }
-
-       headers["X-PHP-Timing"]?.let { timing ->
-           Log.d("PerfTiming", "⏱️ PHP_TIMING $timing")
-       }
-
-       headers.entries
-           .filter { it.key.equals("Set-Cookie", ignoreCase = true) }
-           .flatMap { it.value.split("\n") }
-           .forEach { cookie ->
-               MobileCookieStore.storeFromSetCookieHeader(cookie)
-               CookieManager.getInstance().setCookie("http://127.0.0.1", cookie)
-               Log.d(TAG, "🍪 Stored cookie from Set-Cookie header: $cookie")
-           }
-
-       CookieManager.getInstance().flush()
-       MobileCookieStore.logAll()
-
-       return Triple(headers, cleanedBody.trim(), statusCode)
-   }
-
-   private fun parseHeaders(lines: List<String>, headers: MutableMap<String, String>): Int? {
-       var code: Int? = null
-       val statusLine = lines.firstOrNull()
-       if (statusLine != null && statusLine.startsWith("HTTP/")) {
-           val statusParts = statusLine.split(" ")
-           if (statusParts.size >= 2) {
-               try {
-                   code = statusParts[1].toInt()
-                   Log.d(TAG, "📋 Parsed status code: $code")
-               } catch (_: Exception) { }
-           }
-       }
-       for (i in 1 until lines.size) {
-           val line = lines[i]
-           val colonIndex = line.indexOf(":")
-           if (colonIndex > 0) {
-               val key = line.substring(0, colonIndex).trim()
-               val value = line.substring(colonIndex + 1).trim()
-               if (key.equals("Set-Cookie", ignoreCase = true)) {
-                   headers.merge(key, value) { old, new -> "$old\n$new" }
-               } else {
-                   headers[key] = value
-               }
-           }
-       }
-       return code
-   }
-
-
+    // WebView does not normalise request header case
+    private fun headerValue(headers: Map<String, String>, name: String): String? {
+        return headers.entries.firstOrNull { it.key.equals(name, ignoreCase = true) }?.value
+    }
 
     private fun errorResponse(code: Int, message: String): WebResourceResponse {
         return WebResourceResponse(
@@ -375,6 +375,12 @@ class MainActivity : FragmentActivity(), WebViewProvider {
             mobileEnv = MobileEnvironment(this)
             mobileEnv.initialize()
 
+            // Bundle and database are ready: boot the engine and framework on
+            // the interpreter pool while the WebView is being set up
+            phpBridge.warmUp { ok ->
+                Log.d("MobileInit", if (ok) "🔥 PHP engine warm" else "⚠️ PHP warm-up failed, first request boots cold")
+            }
+
             Log.d("MobileInit", "✅ Mobile environment ready — continuing")
 
             Handler(Looper.getMainLooper()).post {
@@ -406,6 +412,12 @@ class MainActivity : FragmentActivity(), WebViewProvider {
         NativePHPLifecycle.post(NativePHPLifecycle.Events.ON_PAUSE)
     }
 
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        Log.d("MainActivity", "🧹 onTrimMemory level=$level")
+        phpBridge.trimMemory(level)
+    }
+
     private fun handleDeepLinkIntent(intent: Intent?) {
         val uri = intent?.data ?: return
         Log.d("DeepLink", "🌐 Received deep link: $uri")
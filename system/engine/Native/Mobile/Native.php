@@ -6,6 +6,13 @@ class Native
 {
     protected static array $queue = [];
 
+    /**
+     * Fibers started by parallel(); async() only suspends these.
+     *
+     * @var \WeakMap<\Fiber, true>|null
+     */
+    protected static ?\WeakMap $fibers = null;
+
     /**
      * Call a native function.
      *
@@ -21,6 +28,163 @@ class Native
         ];
     }
 
+    /**
+     * Call a native bridge function synchronously and return its result.
+     *
+     * Parameters and result cross the bridge as PHP arrays, converted
+     * directly to and from Java maps by the nativephp extension.
+     *
+     * @param string $function Fully qualified bridge function (e.g. "Edge.Set")
+     * @param array $parameters
+     * @return array|null Result, or null when not running on device or the
+     *                    function is not registered
+     */
+    public static function invoke(string $function, array $parameters = []): ?array
+    {
+        if (!function_exists('nativephp_call')) {
+            return null;
+        }
+
+        return nativephp_call($function, $parameters);
+    }
+
+    /**
+     * Call several native bridge functions in one bridge crossing.
+     *
+     * Calls run in order on the native side; the registry is consulted once
+     * for the whole batch, so a multi-call action costs about one call.
+     *
+     * @param array $calls List of ['name' => string, 'params' => array]
+     * @return array One result per call, null where the function is not
+     *               registered (all null when not running on device)
+     */
+    public static function invokeMany(array $calls): array
+    {
+        $calls = array_values($calls);
+
+        if (!function_exists('nativephp_call_many')) {
+            return array_fill(0, count($calls), null);
+        }
+
+        return nativephp_call_many($calls) ?? array_fill(0, count($calls), null);
+    }
+
+    /**
+     * Call a native bridge function on the native side's own executor.
+     *
+     * Inside a parallel() task this suspends the task's Fiber until the
+     * result is ready, letting the other tasks' calls run meanwhile.
+     * Anywhere else it simply waits for the result.
+     *
+     * @param string $function Fully qualified bridge function
+     * @param array $parameters
+     * @return array|null Result, or null when not running on device, the
+     *                    function is not registered or the request's
+     *                    deadline passed first
+     */
+    public static function async(string $function, array $parameters = []): ?array
+    {
+        if (!function_exists('nativephp_call_async')) {
+            return null;
+        }
+
+        $ticket = nativephp_call_async($function, $parameters);
+        if ($ticket === 0) {
+            return null;
+        }
+
+        $fiber = \Fiber::getCurrent();
+        if ($fiber !== null && self::$fibers !== null && isset(self::$fibers[$fiber])) {
+            return \Fiber::suspend($ticket);
+        }
+
+        nativephp_await([$ticket]);
+        return nativephp_result($ticket);
+    }
+
+    /**
+     * Run tasks as Fibers so their Native::async() calls overlap.
+     *
+     * The whole batch takes about as long as its slowest native call
+     * instead of the sum of all of them. When the request's deadline passes
+     * first, every pending call is given up and its task returns null.
+     *
+     * @param array<array-key, callable> $tasks
+     * @return array Each task's return value, under the task's key
+     */
+    public static function parallel(array $tasks): array
+    {
+        self::$fibers ??= new \WeakMap();
+
+        $fibers = [];
+        $waiting = []; // ticket => task key
+        $results = [];
+
+        foreach ($tasks as $key => $task) {
+            $fiber = new \Fiber($task);
+            self::$fibers[$fiber] = true;
+            $fibers[$key] = $fiber;
+            self::settle($key, $fiber, $fiber->start(), $waiting, $results);
+        }
+
+        while (!empty($waiting)) {
+            $ticket = nativephp_await(array_keys($waiting));
+
+            // Deadline reached or tickets lost: give up whatever is still pending
+            if ($ticket === null) {
+                foreach (array_keys($waiting) as $pending) {
+                    nativephp_result($pending);
+                }
+                break;
+            }
+
+            $key = $waiting[$ticket];
+            unset($waiting[$ticket]);
+
+            $result = nativephp_result($ticket);
+            self::settle($key, $fibers[$key], $fibers[$key]->resume($result), $waiting, $results);
+        }
+
+        $ordered = [];
+        foreach (array_keys($tasks) as $key) {
+            $ordered[$key] = $results[$key] ?? null;
+        }
+        return $ordered;
+    }
+
+    /**
+     * Record a task's return value, or the ticket it is now waiting on.
+     *
+     * @param int|string $key
+     * @param \Fiber $fiber
+     * @param mixed $ticket Value the Fiber suspended with
+     * @param array $waiting
+     * @param array $results
+     * @return void
+     */
+    protected static function settle(int|string $key, \Fiber $fiber, mixed $ticket, array &$waiting, array &$results): void
+    {
+        if ($fiber->isTerminated()) {
+            $results[$key] = $fiber->getReturn();
+            return;
+        }
+
+        $waiting[$ticket] = $key;
+    }
+
+    /**
+     * Discard any queued native calls without dispatching them.
+     *
+     * Used by the mobile worker so a failed request cannot leak its
+     * queued calls into the next one.
+     *
+     * @return void
+     */
+    public static function reset(): void
+    {
+        self::$queue = [];
+    }
+
     /**
      * Get and clear the queue of native calls.
      *
@@ -58,6 +58,16 @@ class Storage
         return false;
     }
 
+    /**
+     * Build a download response for a stored file.
+     *
+     * The file is not read into PHP; see Response::file().
+     */
+    public static function download(string $path, ?string $name = null): \Engine\Http\Response
+    {
+        return (new \Engine\Http\Response())->download(self::path($path), $name);
+    }
+
     /**
      * Get the public URL for a file.
      * Assumes 'storage' folder in public is linked to storage/public
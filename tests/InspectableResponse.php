@@ -0,0 +1,18 @@
+<?php
+require_once __DIR__ . '/../system/engine/Http/Response.php';
+
+use Engine\Http\Response;
+
+// Exposes the state send() would put on the wire
+class InspectableResponse extends Response
+{
+    public function status(): int
+    {
+        return $this->status;
+    }
+
+    public function headerValue(string $name): ?string
+    {
+        return $this->headers[$name] ?? null;
+    }
+}
@@ -0,0 +1,116 @@
+<?php
+require_once __DIR__ . '/check.php';
+require_once __DIR__ . '/InspectableResponse.php';
+
+function tagged(string $etag): InspectableResponse
+{
+    $res = new InspectableResponse();
+    return $res->raw('body')->header('ETag', $etag);
+}
+
+// --- If-None-Match ---
+
+$res = tagged('"abc"');
+check('strong tag matches itself', $res->isNotModified(['HTTP_IF_NONE_MATCH' => '"abc"']) && $res->status() === 304);
+
+$res = tagged('"abc"');
+check('weak If-None-Match matches a strong tag', $res->isNotModified(['HTTP_IF_NONE_MATCH' => 'W/"abc"']));
+
+$res = tagged('W/"abc"');
+check('strong If-None-Match matches a weak tag', $res->isNotModified(['HTTP_IF_NONE_MATCH' => '"abc"']));
+
+$res = tagged('"abc"');
+check('tag found in a list', $res->isNotModified(['HTTP_IF_NONE_MATCH' => '"x", W/"y" , "abc"']));
+
+$res = tagged('"abc"');
+check('* matches any tag', $res->isNotModified(['HTTP_IF_NONE_MATCH' => '*']));
+
+$res = tagged('"abc"');
+check('other tag does not match', !$res->isNotModified(['HTTP_IF_NONE_MATCH' => '"abd"']) && $res->status() === 200);
+
+$res = tagged('"abc"');
+check('quotes are part of the tag', !$res->isNotModified(['HTTP_IF_NONE_MATCH' => 'abc']));
+
+$res = (new InspectableResponse())->raw('body');
+check('If-None-Match without an ETag does not match', !$res->isNotModified(['HTTP_IF_NONE_MATCH' => '"abc"']));
+
+// --- If-Modified-Since ---
+
+$modified = gmmktime(12, 0, 0, 1, 1, 2025);
+
+$res = (new InspectableResponse())->raw('body')->lastModified($modified);
+check('unchanged since If-Modified-Since', $res->isNotModified([
+    'HTTP_IF_MODIFIED_SINCE' => gmdate('D, d M Y H:i:s', $modified) . ' GMT',
+]));
+
+$res = (new InspectableResponse())->raw('body')->lastModified($modified);
+check('changed after If-Modified-Since', !$res->isNotModified([
+    'HTTP_IF_MODIFIED_SINCE' => gmdate('D, d M Y H:i:s', $modified - 60) . ' GMT',
+]));
+
+$res = (new InspectableResponse())->raw('body')->lastModified($modified);
+check('unparsable If-Modified-Since is ignored', !$res->isNotModified(['HTTP_IF_MODIFIED_SINCE' => 'yesterday-ish']));
+
+$res = tagged('"abc"')->lastModified($modified);
+check('If-None-Match takes precedence over If-Modified-Since', !$res->isNotModified([
+    'HTTP_IF_NONE_MATCH' => '"old"',
+    'HTTP_IF_MODIFIED_SINCE' => gmdate('D, d M Y H:i:s', $modified + 60) . ' GMT',
+]));
+
+// --- Only fresh GET/HEAD responses qualify ---
+
+$res = tagged('"abc"');
+check('POST is never not-modified', !$res->isNotModified(['REQUEST_METHOD' => 'POST', 'HTTP_IF_NONE_MATCH' => '"abc"']));
+
+$res = tagged('"abc"');
+check('HEAD can be not-modified', $res->isNotModified(['REQUEST_METHOD' => 'HEAD', 'HTTP_IF_NONE_MATCH' => '"abc"']));
+
+$res = tagged('"abc"')->setStatus(404);
+check('error status is never not-modified', !$res->isNotModified(['HTTP_IF_NONE_MATCH' => '"abc"']));
+
+// --- 304 strips the body headers ---
+
+$res = tagged('"abc"')
+    ->header('Content-Length', '4')
+    ->header('Content-Range', 'bytes 0-3/4')
+    ->header('X-Sendfile', '/tmp/file');
+$res->isNotModified(['HTTP_IF_NONE_MATCH' => '"abc"']);
+check('304 drops Content-Length', $res->headerValue('Content-Length') === null);
+check('304 drops Content-Range', $res->headerValue('Content-Range') === null);
+check('304 drops X-Sendfile', $res->headerValue('X-Sendfile') === null);
+check('304 keeps the ETag', $res->headerValue('ETag') === '"abc"');
+
+// --- send() adds an ETag and answers 304 for it ---
+
+$_SERVER['REQUEST_METHOD'] = 'GET';
+unset($_SERVER['HTTP_IF_NONE_MATCH'], $_SERVER['HTTP_IF_MODIFIED_SINCE']);
+
+$res = (new InspectableResponse())->raw('hello');
+ob_start();
+$res->send();
+$output = ob_get_clean();
+$etag = '"' . hash('xxh3', 'hello') . '"';
+check('send() tags a 200 body', $res->headerValue('ETag') === $etag && $output === 'hello');
+
+$_SERVER['HTTP_IF_NONE_MATCH'] = $etag;
+$res = (new InspectableResponse())->raw('hello');
+ob_start();
+$res->send();
+$output = ob_get_clean();
+check('send() answers a matching If-None-Match with an empty 304', $res->status() === 304 && $output === '');
+
+$res = (new InspectableResponse())->raw('hello')->etag('v1');
+ob_start();
+$res->send();
+ob_end_clean();
+check('send() keeps an explicit ETag', $res->headerValue('ETag') === '"v1"' && $res->status() === 200);
+
+$res = (new InspectableResponse())->raw('missing', 'text/plain', 404);
+ob_start();
+$res->send();
+ob_end_clean();
+check('send() does not tag an error', $res->headerValue('ETag') === null);
+
+unset($_SERVER['HTTP_IF_NONE_MATCH']);
+
+checks_done('conditional GET');
@@ -0,0 +1,46 @@
+<?php
+require_once __DIR__ . '/check.php';
+require_once __DIR__ . '/InspectableResponse.php';
+
+use Engine\Http\Response;
+
+// --- Range parsing ---
+
+check('plain range', Response::parseRange('bytes=0-99', 1000) === [0, 99]);
+check('open-ended range', Response::parseRange('bytes=500-', 1000) === [500, 999]);
+check('range end clamped to EOF', Response::parseRange('bytes=990-2000', 1000) === [990, 999]);
+check('whitespace and unit case allowed', Response::parseRange(' Bytes = 10 - 19 ', 1000) === [10, 19]);
+check('suffix range', Response::parseRange('bytes=-100', 1000) === [900, 999]);
+check('suffix range longer than the file', Response::parseRange('bytes=-2000', 1000) === [0, 999]);
+check('zero-length suffix is unsatisfiable', Response::parseRange('bytes=-0', 1000) === false);
+check('suffix of an empty file is unsatisfiable', Response::parseRange('bytes=-10', 0) === false);
+check('start at EOF is unsatisfiable', Response::parseRange('bytes=1000-', 1000) === false);
+check('range past EOF is unsatisfiable', Response::parseRange('bytes=1500-1600', 1000) === false);
+check('multiple ranges are ignored', Response::parseRange('bytes=0-1,5-6', 1000) === null);
+check('other units are ignored', Response::parseRange('items=0-1', 1000) === null);
+check('malformed range is ignored', Response::parseRange('bytes=abc', 1000) === null);
+check('range without bounds is ignored', Response::parseRange('bytes=-', 1000) === null);
+check('reversed range is ignored', Response::parseRange('bytes=9-3', 1000) === null);
+
+// --- stream() ---
+
+$path = tempnam(sys_get_temp_dir(), 'range');
+file_put_contents($path, str_repeat('x', 100));
+
+$res = (new InspectableResponse())->stream($path, 'text/plain', 'bytes=10-19');
+check('stream() answers a range with 206', $res->status() === 206
+    && $res->headerValue('Content-Range') === 'bytes 10-19/100'
+    && $res->headerValue('Content-Length') === '10');
+
+$res = (new InspectableResponse())->stream($path, 'text/plain', 'bytes=200-');
+check('stream() answers a range past EOF with 416', $res->status() === 416
+    && $res->headerValue('Content-Range') === 'bytes */100');
+
+$res = (new InspectableResponse())->stream($path, 'text/plain', 'bytes=0-1,5-6');
+check('stream() sends the whole file for an ignored range', $res->status() === 200
+    && $res->headerValue('Content-Length') === '100'
+    && $res->headerValue('Content-Range') === null);
+
+unlink($path);
+
+checks_done('range');
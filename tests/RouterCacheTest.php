@@ -0,0 +1,43 @@
+<?php
+require_once __DIR__ . '/check.php';
+require_once __DIR__ . '/../system/engine/Core/Config.php';
+require_once __DIR__ . '/../system/engine/Http/Router.php';
+
+use Engine\Core\Config;
+use Engine\Http\Router;
+
+Config::load(['app' => ['base_path' => '']]);
+
+$router = new Router();
+$router->get('/docs', fn() => 'docs')->cache(300, ['session', 'Accept'], ['docs', 'nav']);
+$router->get('/art/{id}', fn($id) => $id)->cache(-10);
+$router->post('/scan', fn() => 'scan');
+$router->get('/plain', fn() => 'plain');
+
+$docs = $router->match('GET', '/docs?section=intro');
+check('cached route matches with a query string', $docs !== null);
+check('cache() stores ttl, vary and tags', ($docs['cache'] ?? null) === [
+    'ttl' => 300,
+    'vary' => ['session', 'Accept'],
+    'tags' => ['docs', 'nav'],
+]);
+
+$art = $router->match('GET', '/art/7');
+check('negative ttl is clamped to 0', ($art['cache']['ttl'] ?? null) === 0);
+check('vary and tags default to empty', ($art['cache']['vary'] ?? null) === [] && ($art['cache']['tags'] ?? null) === []);
+
+$scan = $router->match('POST', '/scan');
+check('cache() only applies to the last route', !isset($scan['cache']));
+
+$plain = $router->match('GET', '/plain');
+check('unmarked route has no cache', !isset($plain['cache']));
+
+$fresh = new Router();
+try {
+    $fresh->cache(60);
+    check('cache() before any route throws', false);
+} catch (\RuntimeException $e) {
+    check('cache() before any route throws', true);
+}
+
+checks_done('route cache');
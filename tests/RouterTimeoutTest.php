@@ -0,0 +1,33 @@
+<?php
+require_once __DIR__ . '/check.php';
+require_once __DIR__ . '/../system/engine/Core/Config.php';
+require_once __DIR__ . '/../system/engine/Http/Router.php';
+
+use Engine\Core\Config;
+use Engine\Http\Router;
+
+Config::load(['app' => ['base_path' => '']]);
+
+$router = new Router();
+$router->post('/scan', fn() => 'scan')->timeout(120);
+$router->post('/forever', fn() => 'forever')->timeout(-1);
+$router->get('/plain', fn() => 'plain');
+
+$scan = $router->match('POST', '/scan');
+check('timeout() stores seconds', ($scan['timeout'] ?? null) === 120);
+
+$forever = $router->match('POST', '/forever');
+check('negative timeout is clamped to 0 (no limit)', ($forever['timeout'] ?? null) === 0);
+
+$plain = $router->match('GET', '/plain');
+check('unmarked route has no timeout', !isset($plain['timeout']));
+
+$fresh = new Router();
+try {
+    $fresh->timeout(5);
+    check('timeout() before any route throws', false);
+} catch (\RuntimeException $e) {
+    check('timeout() before any route throws', true);
+}
+
+checks_done('route timeout');
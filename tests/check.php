@@ -0,0 +1,21 @@
+<?php
+// Shared by the script tests: check() prints PASS/FAIL per check and
+// checks_done() exits non-zero when any of them failed.
+
+$failures = 0;
+
+function check(string $label, bool $ok): void
+{
+    global $failures;
+    echo ($ok ? 'PASS' : 'FAIL') . ": $label\n";
+    if (!$ok) {
+        $failures++;
+    }
+}
+
+function checks_done(string $subject): void
+{
+    global $failures;
+    echo $failures === 0 ? "All $subject checks passed.\n" : "$failures $subject check(s) failed.\n";
+    exit($failures === 0 ? 0 : 1);
+}